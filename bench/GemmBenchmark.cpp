@@ -0,0 +1,98 @@
+#include "../src/matrix_wrapper/Matrix.h"
+#include "../src/matrix_wrapper/MatrixFactory.h"
+#include "../src/representations/DenseMatrix.h"
+#include "../src/representations/SparseMatrix.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares the blocked dense kernel used by Matrix::operator* with the
+// textbook i-j-k loop going through the virtual MatrixMemoryRepr interface,
+// which Matrix::operator* used before.
+//
+// usage: gemm_bench [--full] [size...]
+//        --full runs the reference implementation for all sizes, it is
+//        skipped for sizes above 256 otherwise
+
+using Clock = std::chrono::steady_clock;
+
+static DenseMatrix random_dense(std::size_t size, std::mt19937 & gen) {
+    std::uniform_real_distribution<double> dist(-1, 1);
+    DenseMatrix result(size, size);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            result.modify(i, j, dist(gen));
+        }
+    }
+    return result;
+}
+
+static void reference_multiply(const MatrixMemoryRepr & lhs,
+                               const MatrixMemoryRepr & rhs,
+                               MatrixMemoryRepr & result) {
+    for (std::size_t i = 0; i < result.rows(); i++) {
+        for (std::size_t j = 0; j < result.columns(); j++) {
+            double result_element = 0;
+            for (std::size_t k = 0; k < lhs.columns(); k++) {
+                result_element += lhs.at(i, k).value() * rhs.at(k, j).value();
+            }
+            result.modify(i, j, result_element);
+        }
+    }
+}
+
+template <typename Fn> static double seconds(Fn && fn) {
+    auto start = Clock::now();
+    fn();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char * argv[]) {
+    bool full = false;
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--full")) {
+            full = true;
+        } else {
+            sizes.emplace_back(std::stoul(argv[i]));
+        }
+    }
+    if (sizes.empty()) {
+        sizes = {64, 128, 256, 512, 1000};
+    }
+
+    MatrixFactory factory(0.5);
+    std::mt19937 gen(42);
+    std::cout << std::setw(6) << "size" << std::setw(16) << "kernel GFLOP/s"
+              << std::setw(19) << "reference GFLOP/s" << std::setw(10)
+              << "speedup" << std::endl;
+
+    for (auto size : sizes) {
+        Matrix lhs(random_dense(size, gen), factory);
+        Matrix rhs(random_dense(size, gen), factory);
+        double flops = 2.0 * size * size * size;
+
+        double kernel_time = seconds([&] { Matrix product = lhs * rhs; });
+        std::cout << std::setw(6) << size << std::setw(16) << std::fixed
+                  << std::setprecision(3) << flops / kernel_time / 1e9;
+
+        if (size > 256 && !full) {
+            std::cout << std::setw(19) << "-" << std::setw(10) << "-"
+                      << std::endl;
+            continue;
+        }
+        DenseMatrix lhs_repr = random_dense(size, gen);
+        DenseMatrix rhs_repr = random_dense(size, gen);
+        SparseMatrix result(size, size);
+        double reference_time = seconds(
+            [&] { reference_multiply(lhs_repr, rhs_repr, result); });
+        std::cout << std::setw(19) << flops / reference_time / 1e9
+                  << std::setw(9) << std::setprecision(1)
+                  << reference_time / kernel_time << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,349 @@
+#include "../libs/json.hpp"
+#include "../src/matrix_operations/MatrixOp.h"
+#include "../src/matrix_operations/OperationFactory.h"
+#include "../src/matrix_wrapper/Matrix.h"
+#include "../src/matrix_wrapper/MatrixFactory.h"
+#include "../src/parallel/ThreadPool.h"
+#include "../src/representations/DenseMatrix.h"
+#include "../src/representations/SparseMatrix.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Measures every arithmetic MatrixOp on square matrices of several sizes and
+// densities, stored both as DenseMatrix and as SparseMatrix. Special cases
+// (assignment, PRINT and the file operations) are evaluated by Evaluator and
+// are measured by timing whole sessions instead.
+//
+// Operations with a cached factorization are also measured on copies of a
+// single matrix, the way the evaluator copies stored variables, as
+// "<name>/cached" cases. Only their first evaluation should factorize.
+//
+// Results are written as JSON. Given a baseline written by an earlier run,
+// the median of every case is compared with the baseline one and the program
+// exits with status 1 if any case got slower than the tolerance allows.
+//
+// usage: op_bench [--quick] [--threads N] [--filter NAME] [--output FILE]
+//                 [--baseline FILE] [--tolerance PERCENT] [size...]
+//        --quick    runs small sizes with short measurements
+//        --filter   runs only the cases containing NAME, eg. "INV/sparse"
+//        --output   writes the results to FILE instead of standard output
+
+using Clock = std::chrono::steady_clock;
+using json = nlohmann::json;
+
+// a case runs at least this many times, and until it took the minimum time
+static constexpr std::size_t MIN_REPETITIONS = 3;
+static constexpr std::size_t MAX_REPETITIONS = 1000;
+
+struct Options {
+    bool quick = false;
+    std::size_t threads = 0;
+    std::string filter;
+    std::string output;
+    std::string baseline;
+    double tolerance = 10;
+    std::vector<std::size_t> sizes;
+};
+
+// an operation from OperationFactory with its arguments, built from a square
+// left and right operand in the reversed order expected by MatrixOp
+struct Operation {
+    const char * name;
+    std::function<std::vector<Matrix>(const Matrix & lhs, const Matrix & rhs,
+                                      std::size_t size)>
+        arguments;
+};
+
+// operations, whose results are cached by the matrix, see FactorizationCache
+static bool is_cached(const std::string & operation) {
+    return operation == "INV" || operation == "DET" || operation == "RANK";
+}
+
+static std::vector<Operation> operations() {
+    auto unary = [](const Matrix & lhs, const Matrix &, std::size_t) {
+        return std::vector<Matrix>{lhs};
+    };
+    auto binary = [](const Matrix & lhs, const Matrix & rhs, std::size_t) {
+        return std::vector<Matrix>{rhs, lhs};
+    };
+    // the middle quarter of the matrix
+    auto cut = [](const Matrix & lhs, const Matrix &, std::size_t size) {
+        double offset = size / 4;
+        double length = size / 2;
+        return std::vector<Matrix>{offset, offset, length, length, lhs};
+    };
+    return {{"+", binary},         {"-", binary},   {"*", binary},
+            {"UNITE", binary},     {"CUT", cut},    {"TRANSPOSE", unary},
+            {"INV", unary},        {"DET", unary},  {"RANK", unary},
+            {"GAUSS", unary}};
+}
+
+// a square matrix with the given density of random off-diagonal elements and
+// a dominant diagonal, so that it's regular and well conditioned
+static std::unique_ptr<MatrixMemoryRepr>
+random_square(std::size_t size, double density, bool sparse,
+              std::mt19937 & gen) {
+    std::unique_ptr<MatrixMemoryRepr> result;
+    if (sparse) {
+        result = std::make_unique<SparseMatrix>(size, size);
+    } else {
+        result = std::make_unique<DenseMatrix>(size, size);
+    }
+    std::uniform_real_distribution<double> value(-1, 1);
+    std::bernoulli_distribution present(density);
+    for (std::size_t i = 0; i < size; i++) {
+        for (std::size_t j = 0; j < size; j++) {
+            if (i == j) {
+                result->modify(i, j, size + 1.0);
+            } else if (present(gen)) {
+                result->modify(i, j, value(gen));
+            }
+        }
+    }
+    return result;
+}
+
+static std::string case_name(const std::string & operation,
+                             const char * representation, std::size_t size,
+                             double density) {
+    std::ostringstream name;
+    name << operation << '/' << representation << '/' << size << '/'
+         << density;
+    return name.str();
+}
+
+// runs the operation on fresh copies of the operands, so that no
+// factorization is reused between repetitions, returns durations in seconds
+static std::vector<double> measure(const MatrixOp & operation,
+                                   const Operation & description,
+                                   const MatrixMemoryRepr & lhs_repr,
+                                   const MatrixMemoryRepr & rhs_repr,
+                                   std::size_t size, MatrixFactory factory,
+                                   double min_time) {
+    std::vector<double> durations;
+    double total = 0;
+    // the first run only warms up caches and the allocator
+    for (std::size_t run = 0;
+         run <= MIN_REPETITIONS ||
+         (total < min_time && durations.size() < MAX_REPETITIONS);
+         run++) {
+        Matrix lhs(lhs_repr, factory);
+        Matrix rhs(rhs_repr, factory);
+        auto args = description.arguments(lhs, rhs, size);
+        auto start = Clock::now();
+        Matrix result = operation.evaluate(args);
+        double duration =
+            std::chrono::duration<double>(Clock::now() - start).count();
+        if (run) {
+            durations.emplace_back(duration);
+            total += duration;
+        }
+    }
+    return durations;
+}
+
+// runs the operation on copies of the same operands, so that every run
+// after the warm-up one reuses the factorization, returns durations in seconds
+static std::vector<double> measure_cached(const MatrixOp & operation,
+                                          const Operation & description,
+                                          const MatrixMemoryRepr & lhs_repr,
+                                          const MatrixMemoryRepr & rhs_repr,
+                                          std::size_t size,
+                                          MatrixFactory factory,
+                                          double min_time) {
+    std::vector<double> durations;
+    double total = 0;
+    Matrix lhs(lhs_repr, factory);
+    Matrix rhs(rhs_repr, factory);
+    for (std::size_t run = 0;
+         run <= MIN_REPETITIONS ||
+         (total < min_time && durations.size() < MAX_REPETITIONS);
+         run++) {
+        auto args = description.arguments(lhs, rhs, size);
+        auto start = Clock::now();
+        Matrix result = operation.evaluate(args);
+        double duration =
+            std::chrono::duration<double>(Clock::now() - start).count();
+        if (run) {
+            durations.emplace_back(duration);
+            total += duration;
+        }
+    }
+    return durations;
+}
+
+static json run(const Options & options) {
+    // inputs and results keep their representations, so that dense and
+    // sparse code paths are measured separately
+    ThreadPool pool(options.threads);
+    MatrixFactory factory(ConversionPolicy(1, 0), &pool);
+    OperationFactory operation_factory;
+    std::vector<double> densities = {1, 0.1, 0.01};
+    double min_time = options.quick ? 0.01 : 0.2;
+
+    json results = json::array();
+    for (auto size : options.sizes) {
+        for (auto density : densities) {
+            for (bool sparse : {false, true}) {
+                const char * representation = sparse ? "sparse" : "dense";
+                std::mt19937 gen(size);
+                auto lhs = random_square(size, density, sparse, gen);
+                auto rhs = random_square(size, density, sparse, gen);
+                for (const auto & description : operations()) {
+                    auto operation =
+                        operation_factory.get_operation(description.name);
+                    for (bool cached : {false, true}) {
+                        if (cached && !is_cached(operation->name())) {
+                            continue;
+                        }
+                        std::string name = case_name(operation->name(),
+                                                     representation, size,
+                                                     density);
+                        if (cached) {
+                            name += "/cached";
+                        }
+                        if (name.find(options.filter) == std::string::npos) {
+                            continue;
+                        }
+                        auto durations =
+                            cached ? measure_cached(*operation, description,
+                                                    *lhs, *rhs, size, factory,
+                                                    min_time)
+                                   : measure(*operation, description, *lhs,
+                                             *rhs, size, factory, min_time);
+                        std::sort(durations.begin(), durations.end());
+                        double median = durations[durations.size() / 2] * 1e9;
+                        std::cerr << std::left << std::setw(32) << name
+                                  << std::right << std::setw(14) << std::fixed
+                                  << std::setprecision(0) << median << " ns"
+                                  << std::endl;
+                        results.push_back(
+                            {{"name", name},
+                             {"operation", operation->name()},
+                             {"representation", representation},
+                             {"size", size},
+                             {"density", density},
+                             {"cached", cached},
+                             {"repetitions", durations.size()},
+                             {"median_ns", median},
+                             {"min_ns", durations.front() * 1e9}});
+                    }
+                }
+            }
+        }
+    }
+    return {{"threads", pool.size()}, {"results", results}};
+}
+
+// annotates the results with the baseline medians, returns the number of
+// cases slower than the tolerance allows
+static std::size_t compare(json & report, const json & baseline,
+                           double tolerance) {
+    std::unordered_map<std::string, double> medians;
+    for (const auto & result : baseline.at("results")) {
+        medians[result.at("name").get<std::string>()] =
+            result.at("median_ns").get<double>();
+    }
+    std::size_t regressions = 0;
+    for (auto & result : report["results"]) {
+        auto found = medians.find(result["name"].get<std::string>());
+        if (found == medians.end() || found->second <= 0) {
+            continue;
+        }
+        double change = result["median_ns"].get<double>() / found->second - 1;
+        bool regression = change * 100 > tolerance;
+        result["baseline_median_ns"] = found->second;
+        result["change_percent"] = change * 100;
+        result["regression"] = regression;
+        if (regression) {
+            regressions++;
+            std::cerr << "regression: " << result["name"].get<std::string>()
+                      << std::fixed << std::setprecision(1) << " +"
+                      << change * 100 << "%" << std::endl;
+        }
+    }
+    report["tolerance_percent"] = tolerance;
+    report["regressions"] = regressions;
+    return regressions;
+}
+
+static Options parse_options(int argc, char * argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        auto value = [&] {
+            if (i + 1 == argc) {
+                throw std::invalid_argument(std::string("Missing value of ") +
+                                            argv[i]);
+            }
+            return std::string(argv[++i]);
+        };
+        if (!std::strcmp(argv[i], "--quick")) {
+            options.quick = true;
+        } else if (!std::strcmp(argv[i], "--threads")) {
+            options.threads = std::stoul(value());
+        } else if (!std::strcmp(argv[i], "--filter")) {
+            options.filter = value();
+        } else if (!std::strcmp(argv[i], "--output")) {
+            options.output = value();
+        } else if (!std::strcmp(argv[i], "--baseline")) {
+            options.baseline = value();
+        } else if (!std::strcmp(argv[i], "--tolerance")) {
+            options.tolerance = std::stod(value());
+        } else {
+            options.sizes.emplace_back(std::stoul(argv[i]));
+        }
+    }
+    if (options.sizes.empty()) {
+        options.sizes = options.quick ? std::vector<std::size_t>{16, 64}
+                                      : std::vector<std::size_t>{64, 128, 256};
+    }
+    return options;
+}
+
+int main(int argc, char * argv[]) {
+    try {
+        Options options = parse_options(argc, argv);
+        // read the baseline first, so that a wrong path fails fast
+        json baseline;
+        if (!options.baseline.empty()) {
+            std::ifstream file(options.baseline);
+            if (!file) {
+                throw std::runtime_error("Couldn't open file: " +
+                                         options.baseline);
+            }
+            baseline = json::parse(file);
+        }
+
+        json report = run(options);
+        std::size_t regressions = 0;
+        if (!options.baseline.empty()) {
+            regressions = compare(report, baseline, options.tolerance);
+        }
+
+        if (options.output.empty()) {
+            std::cout << report.dump(3) << std::endl;
+        } else {
+            std::ofstream file(options.output);
+            file << report.dump(3) << std::endl;
+            if (!file) {
+                throw std::runtime_error("Couldn't write file: " +
+                                         options.output);
+            }
+        }
+        return regressions ? 1 : 0;
+    } catch (std::exception & e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -1,35 +1,132 @@
 #include "MatrixCalculator.h"
+#include <algorithm>
+#include <chrono>
 #include <exception>
+#include <iomanip>
+#include <utility>
+#include <vector>
 #include "../exceptions/QuitSignal.h"
 
+// number of the slowest lines listed in the summary of a script
+static constexpr std::size_t SLOWEST_LINES = 10;
+
+using Clock = std::chrono::steady_clock;
+
+// time spent on a line of a script, which starts with the given line
+struct LineTime {
+    std::size_t line;
+    std::chrono::nanoseconds time;
+};
+
+static double milliseconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+static void print_summary(std::vector<LineTime> times, std::size_t failed,
+                          std::ostream & report) {
+    std::chrono::nanoseconds total(0);
+    for (const auto & [line, time] : times) {
+        total += time;
+    }
+    std::sort(times.begin(), times.end(),
+              [](const LineTime & lhs, const LineTime & rhs) {
+                  return lhs.time > rhs.time;
+              });
+    report << std::fixed << std::setprecision(3) << "Lines: " << times.size()
+           << " evaluated, " << failed << " failed, total "
+           << milliseconds(total) << " ms";
+    if (times.empty()) {
+        report << '\n';
+        return;
+    }
+    report << ", mean " << milliseconds(total / times.size())
+           << " ms, median " << milliseconds(times[times.size() / 2].time)
+           << " ms\nSlowest lines:\n";
+    for (std::size_t i = 0; i < std::min(times.size(), SLOWEST_LINES); i++) {
+        report << "  line " << std::setw(8) << times[i].line << ": "
+               << milliseconds(times[i].time) << " ms\n";
+    }
+}
+
 MatrixCalculator::MatrixCalculator(std::istream & input, std::ostream & output,
                                    const std::string & config_file)
     : _config(output), _in(input), _out(output) {
     if (!config_file.empty()) {
         _config.load_config(config_file.c_str());
     }
+    _pool = std::make_unique<ThreadPool>(_config.threads);
+    // matrices are printed with the precision of the stream
+    _out.precision(_config.print_precision);
 }
 
 void MatrixCalculator::start() {
-    Parser parser(MatrixFactory(_config.sparse_ratio), _in,
-                  _config.max_input_length);
-    Evaluator evaluator(MatrixFactory(_config.sparse_ratio), _out);
+    MatrixFactory factory = make_factory();
+    Parser parser(factory, _in, _config.max_input_length);
+    Evaluator evaluator(factory, _out, make_export_options());
     std::string prefix;
     while (!_in.eof()) {
         if (!_in.good()){
             return;
         }
         try {
-            _out << prefix << ">>> ";
+            // results are buffered, the prompt has to be seen before reading
+            _out << prefix << ">>> " << std::flush;
             auto parsed_input = parser.parse_input();
             evaluator.evaluate_input(parsed_input);
             prefix.clear();
         } catch (QuitSignal &) {
             return;
         } catch (std::exception & e){
-            _out << e.what() << std::endl;
+            _out << e.what() << '\n';
             prefix = "!**";
             continue;
         }
     }
 }
+
+std::size_t MatrixCalculator::run_script(bool stop_on_error,
+                                         std::ostream & report) {
+    MatrixFactory factory = make_factory();
+    Parser parser(factory, _in, _config.max_input_length);
+    Evaluator evaluator(factory, _out, make_export_options());
+    std::vector<LineTime> times;
+    std::size_t failed = 0;
+    // the end is detected before parsing, so that every exception is an
+    // error of the script
+    while (_in.peek() != std::istream::traits_type::eof()) {
+        std::size_t line = parser.lines_read() + 1;
+        auto start = Clock::now();
+        try {
+            auto parsed_input = parser.parse_input();
+            evaluator.evaluate_input(parsed_input);
+            times.push_back({line, Clock::now() - start});
+        } catch (QuitSignal &) {
+            times.push_back({line, Clock::now() - start});
+            break;
+        } catch (std::exception & e) {
+            times.push_back({line, Clock::now() - start});
+            _out << "Error on line " << line << ": " << e.what() << '\n';
+            ++failed;
+            if (stop_on_error) {
+                break;
+            }
+        }
+    }
+    // results precede the summary when both are shown in a terminal
+    _out.flush();
+    print_summary(std::move(times), failed, report);
+    return failed;
+}
+
+MatrixFactory MatrixCalculator::make_factory() const {
+    return MatrixFactory(
+        ConversionPolicy(_config.sparse_ratio, _config.dense_ratio),
+        _pool.get());
+}
+
+ExportOptions MatrixCalculator::make_export_options() const {
+    ExportOptions export_options;
+    export_options.compact = _config.compact_export;
+    export_options.sharded = _config.shard_export;
+    return export_options;
+}
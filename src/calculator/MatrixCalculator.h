@@ -3,7 +3,9 @@
 #include "../handlers/config_handling/Configurator.h"
 #include "../handlers/input_handling/Evaluator.h"
 #include "../handlers/input_handling/Parser.h"
+#include "../parallel/ThreadPool.h"
 #include <iostream>
+#include <memory>
 
 /**
  * @brief Main class of the project. Implements a matrix calculator.
@@ -27,14 +29,45 @@ class MatrixCalculator {
      */
     void start();
 
+    /**
+     * @brief Evaluates the input as a script until EOF is reached. No
+     *        prompts are printed, errors are printed with the number of the
+     *        line which caused them and the result stream is flushed only at
+     *        the end. A summary of the time spent on the lines is written to
+     *        <b>report</b>.
+     * @param stop_on_error Stops at the first line which fails if true,
+     *                      continues with the next line otherwise.
+     * @param report Stream for the timing summary.
+     * @return Number of lines which failed.
+     */
+    std::size_t run_script(bool stop_on_error, std::ostream & report);
+
   private:
 
+    /**
+     * @brief Creates a matrix factory following the configuration.
+     * @return The factory.
+     */
+    MatrixFactory make_factory() const;
+
+    /**
+     * @brief Collects the export options of the configuration.
+     * @return The options.
+     */
+    ExportOptions make_export_options() const;
+
     /**
      * @brief A configuration unit used to tweak the matrix creation process
      *        and maximum allowed length of user input.
      */
     Configurator _config;
 
+    /**
+     * @brief Thread pool shared by all matrices of the calculator. Created
+     *        after the configuration is loaded, as its size is configurable.
+     */
+    std::unique_ptr<ThreadPool> _pool;
+
     /**
      * @brief Stream for reading user input.
      */
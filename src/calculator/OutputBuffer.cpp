@@ -0,0 +1,54 @@
+#include "OutputBuffer.h"
+
+OutputBuffer::OutputBuffer(std::streambuf * target, std::size_t capacity)
+    : _target(target), _block(capacity) {
+    setp(_block.data(), _block.data() + _block.size());
+}
+
+OutputBuffer::~OutputBuffer() {
+    sync();
+}
+
+OutputBuffer::int_type OutputBuffer::overflow(int_type ch) {
+    if (!write_block()) {
+        return traits_type::eof();
+    }
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+std::streamsize OutputBuffer::xsputn(const char * s, std::streamsize count) {
+    if (count <= epptr() - pptr()) {
+        traits_type::copy(pptr(), s, count);
+        pbump(static_cast<int>(count));
+        return count;
+    }
+    // keeps the order of the output, the block goes first
+    if (!write_block()) {
+        return 0;
+    }
+    if (static_cast<std::size_t>(count) >= _block.size()) {
+        return _target->sputn(s, count);
+    }
+    traits_type::copy(pptr(), s, count);
+    pbump(static_cast<int>(count));
+    return count;
+}
+
+int OutputBuffer::sync() {
+    if (!write_block()) {
+        return -1;
+    }
+    return _target->pubsync();
+}
+
+bool OutputBuffer::write_block() {
+    std::streamsize size = pptr() - pbase();
+    bool written = !size || _target->sputn(pbase(), size) == size;
+    setp(_block.data(), _block.data() + _block.size());
+    return written;
+}
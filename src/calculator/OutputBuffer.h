@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+
+/**
+ * @brief A stream buffer collecting output in a large block and passing it
+ *        to another stream buffer only when the block is full or when the
+ *        stream is flushed. Used by the batch mode, so that results of
+ *        thousands of lines are written with a few system calls.
+ */
+class OutputBuffer : public std::streambuf {
+  public:
+
+    /**
+     * @brief Initializes the buffer.
+     * @param target Stream buffer receiving the output.
+     * @param capacity Size of the block in bytes.
+     */
+    OutputBuffer(std::streambuf * target, std::size_t capacity);
+
+    OutputBuffer(const OutputBuffer &) = delete;
+
+    OutputBuffer & operator=(const OutputBuffer &) = delete;
+
+    /**
+     * @brief Writes the rest of the output to the target.
+     */
+    ~OutputBuffer() override;
+
+  protected:
+
+    /**
+     * @brief Writes the full block to the target and stores <b>ch</b>.
+     * @param ch Character which didn't fit the block.
+     * @return <b>ch</b>, or EOF if the target failed.
+     */
+    int_type overflow(int_type ch) override;
+
+    /**
+     * @brief Writes long sequences directly to the target, shorter ones are
+     *        copied to the block.
+     * @param s Characters to write.
+     * @param count Number of characters.
+     * @return Number of characters written.
+     */
+    std::streamsize xsputn(const char * s, std::streamsize count) override;
+
+    /**
+     * @brief Writes the block to the target and flushes it.
+     * @return 0 on success, -1 if the target failed.
+     */
+    int sync() override;
+
+  private:
+
+    /**
+     * @brief Writes the block to the target and empties it.
+     * @return True if the target accepted all characters.
+     */
+    bool write_block();
+
+    std::streambuf * _target;
+
+    std::vector<char> _block;
+};
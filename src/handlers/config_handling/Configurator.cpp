@@ -17,6 +17,21 @@ inline const std::vector<std::string> required_attrs {
     "max_input_length"
 };
 
+inline const std::vector<std::string> optional_attrs {
+    "dense_ratio",
+    "threads",
+    "compact_export",
+    "shard_export",
+    "print_precision"
+};
+
+// an upper bound for the number of threads, to catch typos in configs
+inline constexpr std::size_t max_threads = 1024;
+
+// more digits don't tell distinct doubles apart
+inline constexpr std::size_t max_print_precision =
+    std::numeric_limits<double>::max_digits10;
+
 using json = nlohmann::json;
 
 static bool check_config(const json & data, const std::vector<std::string> & attrs){
@@ -28,6 +43,16 @@ static bool check_config(const json & data, const std::vector<std::string> & att
     return true;
 }
 
+static std::size_t count_present(const json & data, const std::vector<std::string> & attrs){
+    std::size_t count = 0;
+    for (const auto & attr : attrs){
+        if (data.contains(attr)){
+            ++count;
+        }
+    }
+    return count;
+}
+
 void Configurator::load_config(const char * file_name) {
     if (!std::filesystem::is_regular_file(file_name)) {
         _stream << "Provided config file is not a regular file, defaulting to: "
@@ -59,7 +84,7 @@ void Configurator::load_config(const char * file_name) {
         print_defaults(_stream);
         return;
     }
-    if (config_data.size() > required_attrs.size()){
+    if (config_data.size() > required_attrs.size() + count_present(config_data, optional_attrs)){
         _stream << "One or more abundant attributes found in config. Defaulting to: " << std::endl;
         set_defaults();
         print_defaults(_stream);
@@ -67,6 +92,11 @@ void Configurator::load_config(const char * file_name) {
     }
     double sparse_r = config_data["sparse_ratio"].get<double>();
     std::size_t max_len = config_data["max_input_length"].get<std::size_t>();
+    bool has_dense_ratio = config_data.contains("dense_ratio");
+    bool has_threads = config_data.contains("threads");
+    bool has_compact_export = config_data.contains("compact_export");
+    bool has_shard_export = config_data.contains("shard_export");
+    bool has_print_precision = config_data.contains("print_precision");
 
     if (sparse_r < 0 || sparse_r > 1){
         _stream << "Invalid value of sparse_ratio. Defaulting to: " << std::endl;
@@ -74,6 +104,20 @@ void Configurator::load_config(const char * file_name) {
         print_defaults(_stream);
         return;
     }
+    double dense_r = sparse_r / 2;
+    if (has_dense_ratio) {
+        if (!config_data["dense_ratio"].is_number()) {
+            dense_r = -1;
+        } else {
+            dense_r = config_data["dense_ratio"].get<double>();
+        }
+    }
+    if (dense_r < 0 || dense_r > sparse_r){
+        _stream << "Invalid value of dense_ratio. Defaulting to: " << std::endl;
+        set_defaults();
+        print_defaults(_stream);
+        return;
+    }
     if (max_len == 0 || max_len == std::numeric_limits<std::size_t>::max()){
         _stream << "Invalid value of max_input_length. Defaulting to: " << std::endl;
         set_defaults();
@@ -81,17 +125,62 @@ void Configurator::load_config(const char * file_name) {
         return;
     }
 
+    if (has_threads && (!config_data["threads"].is_number_unsigned() ||
+                        config_data["threads"].get<std::size_t>() > max_threads)){
+        _stream << "Invalid value of threads. Defaulting to: " << std::endl;
+        set_defaults();
+        print_defaults(_stream);
+        return;
+    }
+
+    if ((has_compact_export && !config_data["compact_export"].is_boolean()) ||
+        (has_shard_export && !config_data["shard_export"].is_boolean())){
+        _stream << "Invalid value of an export option. Defaulting to: " << std::endl;
+        set_defaults();
+        print_defaults(_stream);
+        return;
+    }
+
+    if (has_print_precision &&
+        (!config_data["print_precision"].is_number_unsigned() ||
+         config_data["print_precision"].get<std::size_t>() == 0 ||
+         config_data["print_precision"].get<std::size_t>() > max_print_precision)){
+        _stream << "Invalid value of print_precision. Defaulting to: " << std::endl;
+        set_defaults();
+        print_defaults(_stream);
+        return;
+    }
+
     sparse_ratio = sparse_r;
+    dense_ratio = dense_r;
     max_input_length = max_len;
+    threads = has_threads ? config_data["threads"].get<std::size_t>() : 0;
+    compact_export = has_compact_export && config_data["compact_export"].get<bool>();
+    shard_export = has_shard_export && config_data["shard_export"].get<bool>();
+    print_precision = has_print_precision
+                          ? config_data["print_precision"].get<std::size_t>()
+                          : 6;
     _stream << "Config file: OK" << std::endl;
 }
 
 void Configurator::print_defaults(std::ostream & os) const {
     os << "\t sparse_ratio = " << sparse_ratio * 100 << "%" << std::endl;
+    os << "\t dense_ratio = " << dense_ratio * 100 << "%" << std::endl;
     os << "\t max_input_length = " << max_input_length << std::endl;
+    os << "\t threads = " << threads << std::endl;
+    os << "\t compact_export = " << std::boolalpha << compact_export
+       << std::noboolalpha << std::endl;
+    os << "\t shard_export = " << std::boolalpha << shard_export
+       << std::noboolalpha << std::endl;
+    os << "\t print_precision = " << print_precision << std::endl;
 }
 
 void Configurator::set_defaults() {
     sparse_ratio = 0.5;
+    dense_ratio = 0.25;
     max_input_length = 500;
+    threads = 0;
+    compact_export = false;
+    shard_export = false;
+    print_precision = 6;
 }
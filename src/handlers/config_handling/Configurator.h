@@ -34,10 +34,44 @@ class Configurator {
      */
     double sparse_ratio;
 
+    /**
+     * @brief Ratio of elements equal to zero, under which a sparse matrix is
+     *        converted to a dense one. Its value ranges between
+     *        [0, <b>sparse_ratio</b>], matrices in between the two ratios
+     *        keep their representation. This attribute is optional and
+     *        defaults to half of <b>sparse_ratio</b>.
+     */
+    double dense_ratio;
+
     /**
      * @brief Maximum length of every expression in input.
      */
     std::size_t max_input_length;
+
+    /**
+     * @brief Number of threads used for operations on matrices. Zero stands
+     *        for the number of hardware threads. This attribute is optional.
+     */
+    std::size_t threads;
+
+    /**
+     * @brief Whether JSON exports are written without indentation. This
+     *        attribute is optional and defaults to false.
+     */
+    bool compact_export;
+
+    /**
+     * @brief Whether JSON exports are split into one file per variable,
+     *        the exported file becomes a manifest listing them. This
+     *        attribute is optional and defaults to false.
+     */
+    bool shard_export;
+
+    /**
+     * @brief Number of significant digits of printed matrix elements, at
+     *        most 17. This attribute is optional and defaults to 6.
+     */
+    std::size_t print_precision;
   private:
 
     /**
@@ -56,7 +90,12 @@ class Configurator {
      * @brief Resets member variables to their default values.
      *        Defaults are:\n
      *        <b>sparse_ratio = 0.5</b>\n
-     *        <b>max_input_len = 500</b>
+     *        <b>dense_ratio = 0.25</b>\n
+     *        <b>max_input_len = 500</b>\n
+     *        <b>threads = 0</b>\n
+     *        <b>compact_export = false</b>\n
+     *        <b>shard_export = false</b>\n
+     *        <b>print_precision = 6</b>
      */
     void set_defaults();
 };
@@ -0,0 +1,32 @@
+#include "BinaryFormat.h"
+#include <cstring>
+
+static_assert(sizeof(BinaryFileHeader) == 32, "Unexpected header padding.");
+static_assert(sizeof(BinarySectionHeader) == 56, "Unexpected header padding.");
+
+bool is_binary_file(const std::string & filename) {
+    std::size_t length = std::strlen(BINARY_EXTENSION);
+    return filename.size() > length &&
+           filename.compare(filename.size() - length, length,
+                            BINARY_EXTENSION) == 0;
+}
+
+std::size_t binary_padding(std::size_t offset) {
+    return (BINARY_ALIGNMENT - offset % BINARY_ALIGNMENT) % BINARY_ALIGNMENT;
+}
+
+std::uint64_t binary_checksum(const void * data, std::size_t size,
+                              std::uint64_t checksum) {
+    constexpr std::uint64_t prime = 0x100000001b3;
+    auto bytes = static_cast<const unsigned char *>(data);
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        checksum = (checksum ^ word) * prime;
+    }
+    for (; i < size; i++) {
+        checksum = (checksum ^ bytes[i]) * prime;
+    }
+    return checksum;
+}
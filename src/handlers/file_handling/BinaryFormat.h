@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file
+ * @brief Layout of the native binary matrix files (<b>.bmx</b>). A file
+ *        starts with a <b>BinaryFileHeader</b>, followed by one section per
+ *        matrix: a <b>BinarySectionHeader</b>, the name of the matrix and
+ *        its payload. Payloads start at offsets aligned to
+ *        <b>BINARY_ALIGNMENT</b> bytes, all numbers are stored in the byte
+ *        order of the machine, which wrote the file.
+ *
+ *        Dense payloads hold <b>rows * stride</b> doubles, row <b>i</b>
+ *        starting at <b>i * stride</b>, in the layout of
+ *        <b>DenseMatrix</b>. Compressed payloads hold <b>rows + 1</b> row
+ *        offsets and <b>nnz</b> column indices as 64-bit unsigned integers
+ *        followed by <b>nnz</b> doubles, in the layout of
+ *        <b>CompressedSparseMatrix</b>.
+ */
+
+/**
+ * @brief Extension of files stored in the binary format.
+ */
+constexpr const char * BINARY_EXTENSION = ".bmx";
+
+/**
+ * @brief Magic bytes at the start of every binary file.
+ */
+constexpr char BINARY_MAGIC[8] = {'B', 'M', 'X', 'F', 'I', 'L', 'E', '\0'};
+
+/**
+ * @brief Version of the format written by <b>Exporter</b>.
+ */
+constexpr std::uint32_t BINARY_VERSION = 1;
+
+/**
+ * @brief Marker used to detect files written with a different byte order.
+ */
+constexpr std::uint32_t BINARY_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief Alignment of payloads in bytes, a multiple of the alignment of
+ *        <b>DenseMatrix</b> buffers.
+ */
+constexpr std::size_t BINARY_ALIGNMENT = 64;
+
+/**
+ * @brief Kinds of matrix sections.
+ */
+enum class BinarySection : std::uint32_t { DENSE = 1, COMPRESSED = 2 };
+
+/**
+ * @brief Header at the start of a binary file.
+ */
+struct BinaryFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t matrices;
+    std::uint64_t reserved;
+};
+
+/**
+ * @brief Header of a single matrix section. The checksum covers the payload,
+ *        see <b>binary_checksum</b>.
+ */
+struct BinarySectionHeader {
+    std::uint64_t rows;
+    std::uint64_t columns;
+    std::uint64_t nnz;
+    std::uint64_t stride;
+    std::uint64_t payload_size;
+    std::uint64_t checksum;
+    std::uint32_t kind;
+    std::uint32_t name_length;
+};
+
+/**
+ * @brief Decides, whether a file should be stored in the binary format,
+ *        based on its extension.
+ * @param filename Name of the file.
+ * @return True if the filename ends with <b>BINARY_EXTENSION</b>.
+ */
+bool is_binary_file(const std::string & filename);
+
+/**
+ * @brief Computes the number of padding bytes needed to align
+ *        <b>offset</b> to <b>BINARY_ALIGNMENT</b>.
+ * @param offset Offset in the file.
+ * @return Number of padding bytes.
+ */
+std::size_t binary_padding(std::size_t offset);
+
+/**
+ * @brief Continues a 64-bit FNV-1a checksum of a payload, processed a word
+ *        at a time. A payload may be fed in several calls, as long as all
+ *        but the last one cover a multiple of 8 bytes.
+ * @param data Bytes to add to the checksum.
+ * @param size Number of bytes.
+ * @param checksum Checksum of the preceding bytes.
+ * @return Checksum including <b>data</b>.
+ */
+std::uint64_t binary_checksum(const void * data, std::size_t size,
+                              std::uint64_t checksum = 0xcbf29ce484222325);
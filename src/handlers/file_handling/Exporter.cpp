@@ -1,58 +1,759 @@
 #include "Exporter.h"
 #include "../../../libs/json.hpp"
+#include "../../representations/DenseMatrix.h"
+#include "../../parallel/ThreadPool.h"
+#include "BinaryFormat.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <iomanip>
+#include <iterator>
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 using json = nlohmann::json;
 
-Exporter::Exporter(MatrixFactory factory) : FileHandler(factory) {}
+Exporter::Exporter(MatrixFactory factory, ExportOptions options)
+    : FileHandler(factory), _options(options) {}
 
-static void write_sparse(json & file, const std::string & name, const Matrix & mx) {
-    for (const auto & [pos, val] : mx) {
-        std::string format = std::to_string(pos.row) + ":" + std::to_string(pos.column);
-        file[name]["data"].emplace(format, val);
+using Variable = std::pair<const std::string, Matrix>;
+
+// number of variables serialized at once by every thread, bounds the memory
+// held by variables waiting to be written
+static constexpr std::size_t VARIABLES_PER_THREAD = 4;
+
+// variables with more written elements are streamed into the file directly
+static constexpr std::size_t LARGE_VARIABLE_ELEMENTS = 1 << 16;
+
+// size of text kept in memory before it's written, when streaming directly
+static constexpr std::size_t FLUSH_SIZE = 1 << 20;
+
+// text of a JSON document being serialized, when a stream is given, the text
+// is written into it in chunks as it grows
+struct JsonBuffer {
+    std::string text;
+    std::ostream * stream = nullptr;
+
+    void flush_if_full() {
+        if (stream && text.size() >= FLUSH_SIZE) {
+            stream->write(text.data(), text.size());
+            text.clear();
+        }
+    }
+};
+
+// matrices with fewer non-zeroes than the factory's ratio allows are written
+// in the sparse layout
+static bool export_as_sparse(const Matrix & mx, double ratio) {
+    std::size_t max_non_zeroes = (1 - ratio) * mx.rows() * mx.columns();
+    return mx.nnz() < max_non_zeroes;
+}
+
+// variables are written sorted by their names, like json objects are dumped
+static std::vector<const Variable *>
+sorted_variables(const std::unordered_map<std::string, Matrix> & vars) {
+    std::vector<const Variable *> result;
+    result.reserve(vars.size());
+    for (const auto & var : vars) {
+        result.push_back(&var);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Variable * lhs, const Variable * rhs) {
+                  return lhs->first < rhs->first;
+              });
+    return result;
+}
+
+// starts a new line indented to the given level, does nothing in compact mode
+static void write_indent(std::string & out, std::size_t level, bool compact) {
+    if (!compact) {
+        out += '\n';
+        out.append(3 * level, ' ');
+    }
+}
+
+static void write_key(std::string & out, const std::string & key,
+                      bool compact) {
+    out += json(key).dump();
+    out += compact ? ":" : ": ";
+}
+
+// numbers are formatted the same way json::dump formats them
+static void write_number(std::string & out, double val) {
+    if (!std::isfinite(val)) {
+        out += "null";
+        return;
+    }
+    char buffer[64];
+    char * end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), val);
+    out.append(buffer, end);
+}
+
+static void write_sparse(JsonBuffer & buffer, const Matrix & mx,
+                         std::size_t level, bool compact) {
+    std::string & out = buffer.text;
+    bool first = true;
+    if (!mx.nnz()) {
+        // matrices without non-zeroes have null data
+        out += "null";
+        return;
+    }
+    out += '{';
+    mx.for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+        buffer.flush_if_full();
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        write_indent(out, level + 1, compact);
+        out += '"';
+        out += std::to_string(row);
+        out += ':';
+        out += std::to_string(column);
+        out += compact ? "\":" : "\": ";
+        write_number(out, val);
+    });
+    write_indent(out, level, compact);
+    out += '}';
+}
+
+static void write_dense(JsonBuffer & buffer, const Matrix & mx,
+                        std::size_t level, bool compact) {
+    std::string & out = buffer.text;
+    out += '{';
+    write_indent(out, level + 1, compact);
+    write_key(out, "array", compact);
+    out += '[';
+    std::vector<double> row_data(mx.columns(), 0);
+    std::size_t written_rows = 0;
+    auto write_rows_until = [&](std::size_t end) {
+        for (; written_rows < end; written_rows++) {
+            if (written_rows) {
+                out += ',';
+            }
+            write_indent(out, level + 2, compact);
+            out += '[';
+            for (std::size_t j = 0; j < row_data.size(); j++) {
+                if (j) {
+                    out += ',';
+                }
+                write_indent(out, level + 3, compact);
+                write_number(out, row_data[j]);
+            }
+            write_indent(out, level + 2, compact);
+            out += ']';
+            std::fill(row_data.begin(), row_data.end(), 0);
+            buffer.flush_if_full();
+        }
+    };
+    mx.for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+        write_rows_until(row);
+        row_data[column] = val;
+    });
+    write_rows_until(mx.rows());
+    write_indent(out, level + 1, compact);
+    out += ']';
+    write_indent(out, level, compact);
+    out += '}';
+}
+
+// appends a single member of the top-level object
+static void write_variable(JsonBuffer & buffer, const Variable & var,
+                           double ratio, bool compact) {
+    std::string & out = buffer.text;
+    const auto & [name, matrix] = var;
+    write_indent(out, 1, compact);
+    write_key(out, name, compact);
+    out += '{';
+    write_indent(out, 2, compact);
+    write_key(out, "columns", compact);
+    out += std::to_string(matrix.columns());
+    out += ',';
+    write_indent(out, 2, compact);
+    write_key(out, "data", compact);
+    if (export_as_sparse(matrix, ratio)) {
+        write_sparse(buffer, matrix, 2, compact);
+    } else {
+        write_dense(buffer, matrix, 2, compact);
+    }
+    out += ',';
+    write_indent(out, 2, compact);
+    write_key(out, "rows", compact);
+    out += std::to_string(matrix.rows());
+    write_indent(out, 1, compact);
+    out += '}';
+}
+
+static bool is_large(const Variable & var, double ratio) {
+    const Matrix & mx = var.second;
+    std::size_t elements = export_as_sparse(mx, ratio)
+                               ? mx.nnz()
+                               : mx.rows() * mx.columns();
+    return elements > LARGE_VARIABLE_ELEMENTS;
+}
+
+// streams members of the top-level object; runs of small variables are
+// serialized in parallel and written in order, large ones are written
+// directly in chunks. Every member but the first one of the object is
+// preceded by a comma.
+static void write_members(std::ostream & out,
+                          const std::vector<const Variable *> & vars,
+                          bool has_members, double ratio, bool compact,
+                          ThreadPool * pool) {
+    std::size_t batch = VARIABLES_PER_THREAD * (pool ? pool->size() : 1);
+    std::vector<JsonBuffer> serialized;
+    std::size_t begin = 0;
+    while (begin < vars.size()) {
+        if (is_large(*vars[begin], ratio)) {
+            JsonBuffer buffer;
+            buffer.stream = &out;
+            if (begin || has_members) {
+                buffer.text += ',';
+            }
+            write_variable(buffer, *vars[begin], ratio, compact);
+            out.write(buffer.text.data(), buffer.text.size());
+            ++begin;
+            continue;
+        }
+        std::size_t end = begin;
+        while (end < vars.size() && end - begin < batch &&
+               !is_large(*vars[end], ratio)) {
+            ++end;
+        }
+        serialized.assign(end - begin, JsonBuffer());
+        parallel_for(pool, begin, end, 1, [&](std::size_t first,
+                                              std::size_t last) {
+            for (std::size_t i = first; i < last; i++) {
+                JsonBuffer & buffer = serialized[i - begin];
+                if (i || has_members) {
+                    buffer.text += ',';
+                }
+                write_variable(buffer, *vars[i], ratio, compact);
+            }
+        });
+        for (const auto & buffer : serialized) {
+            out.write(buffer.text.data(), buffer.text.size());
+        }
+        begin = end;
+    }
+}
+
+// streams the variables into a JSON document
+static void write_json(std::ostream & out,
+                       const std::vector<const Variable *> & vars,
+                       double ratio, bool compact, ThreadPool * pool) {
+    out << '{';
+    write_members(out, vars, false, ratio, compact, pool);
+    if (!compact && !vars.empty()) {
+        out << '\n';
+    }
+    out << '}';
+}
+
+using Shards = std::vector<std::pair<std::string, std::string>>;
+
+// writes every variable into its own file in parallel, shards[i] names the
+// file of vars[i]
+static void write_shards(const std::filesystem::path & directory,
+                         const std::vector<const Variable *> & vars,
+                         const std::vector<std::string> & shards,
+                         double ratio, bool compact, ThreadPool * pool) {
+    parallel_for(pool, 0, vars.size(), 1,
+                 [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            std::filesystem::path shard_path = directory / shards[i];
+            std::ofstream shard(shard_path);
+            write_json(shard, {vars[i]}, ratio, compact, nullptr);
+            if (!shard.is_open() || shard.fail() || shard.bad()) {
+                throw std::runtime_error("Couldn't write file: " +
+                                         shard_path.string());
+            }
+        }
+    });
+}
+
+// writes a manifest mapping names of the variables to their shards
+static void write_manifest(const std::string & filename, const Shards & shards,
+                           bool compact) {
+    std::string manifest = "{";
+    for (std::size_t i = 0; i < shards.size(); i++) {
+        if (i) {
+            manifest += ',';
+        }
+        write_indent(manifest, 1, compact);
+        write_key(manifest, shards[i].first, compact);
+        manifest += json(shards[i].second).dump();
+    }
+    if (!compact && !shards.empty()) {
+        manifest += '\n';
+    }
+    manifest += '}';
+    std::ofstream outfile(filename);
+    outfile << manifest;
+    if (!outfile.is_open() || outfile.fail() || outfile.bad()) {
+        throw std::runtime_error("Couldn't write file: " + filename);
+    }
+}
+
+// shards are numbered, names of variables may not be valid filenames
+static std::string shard_name(const std::string & manifest,
+                              std::size_t index) {
+    std::filesystem::path manifest_path(manifest);
+    return manifest_path.stem().string() + "." + std::to_string(index) +
+           manifest_path.extension().string();
+}
+
+void Exporter::export_shards(
+    const std::unordered_map<std::string, Matrix> & vars,
+    const std::string & filename) const {
+    auto sorted = sorted_variables(vars);
+    Shards shards;
+    std::vector<std::string> shard_names;
+    for (std::size_t i = 0; i < sorted.size(); i++) {
+        shard_names.push_back(shard_name(filename, i));
+        shards.emplace_back(sorted[i]->first, shard_names.back());
+    }
+    write_shards(std::filesystem::path(filename).parent_path(), sorted,
+                 shard_names, _factory.ratio(), _options.compact,
+                 _factory.pool());
+    write_manifest(filename, shards, _options.compact);
+}
+
+void Exporter::update_shards(
+    const std::unordered_map<std::string, Matrix> & vars,
+    const std::string & filename) const {
+    std::ifstream infile(filename);
+    json manifest = json::parse(infile, nullptr, false);
+    if (!manifest.is_object()) {
+        throw std::runtime_error("Cannot update file: " + filename);
+    }
+    std::map<std::string, std::string> shards;
+    std::unordered_set<std::string> used_names;
+    for (const auto & [name, shard] : manifest.items()) {
+        if (!shard.is_string()) {
+            throw std::runtime_error("Cannot update file: " + filename);
+        }
+        shards.emplace(name, shard.get<std::string>());
+        used_names.insert(shard.get<std::string>());
+    }
+
+    // changed variables keep their shards, new ones get unused numbers
+    auto sorted = sorted_variables(vars);
+    std::vector<std::string> shard_names;
+    std::size_t next_index = shards.size();
+    for (const Variable * var : sorted) {
+        auto shard = shards.find(var->first);
+        if (shard == shards.end()) {
+            while (used_names.count(shard_name(filename, next_index))) {
+                ++next_index;
+            }
+            std::string name = shard_name(filename, next_index);
+            used_names.insert(name);
+            shard = shards.emplace(var->first, name).first;
+        }
+        shard_names.push_back(shard->second);
+    }
+    write_shards(std::filesystem::path(filename).parent_path(), sorted,
+                 shard_names, _factory.ratio(), _options.compact,
+                 _factory.pool());
+    write_manifest(filename, Shards(shards.begin(), shards.end()),
+                   _options.compact);
+}
+
+// appends members to a JSON file in place of the closing brace of its
+// top-level object, importing keeps the last member of every name
+static void append_json(const std::unordered_map<std::string, Matrix> & vars,
+                        const std::string & filename, double ratio,
+                        bool compact, ThreadPool * pool) {
+    std::ifstream infile(filename, std::ios::binary);
+    if (!infile.is_open()) {
+        throw std::runtime_error("Couldn't open file: " + filename);
+    }
+    // finds the last non-whitespace character before position
+    auto last_character = [&infile](std::streamoff & position) {
+        char c = 0;
+        while (position > 0) {
+            infile.seekg(position - 1);
+            infile.get(c);
+            if (!std::isspace(static_cast<unsigned char>(c))) {
+                break;
+            }
+            --position;
+        }
+        return c;
+    };
+    std::streamoff end = std::filesystem::file_size(filename);
+    if (last_character(end) != '}') {
+        throw std::runtime_error("Cannot update file: " + filename);
+    }
+    std::streamoff members_end = end - 1;
+    bool has_members = last_character(members_end) != '{';
+    infile.close();
+
+    std::filesystem::resize_file(filename, members_end);
+    std::ofstream outfile(filename, std::ios::app);
+    write_members(outfile, sorted_variables(vars), has_members, ratio,
+                  compact, pool);
+    outfile << (compact ? "}" : "\n}");
+    if (!outfile.is_open() || outfile.fail() || outfile.bad()) {
+        throw std::runtime_error("An error occured while writing data.");
     }
 }
 
-static void write_dense(json & file, const std::string & name, const Matrix & mx) {
-    std::vector<std::vector<double>> data_vec(mx.rows());
-    for (auto & row : data_vec){
-        row.resize(mx.columns());
+static void write_padding(std::ostream & out) {
+    static const char zeroes[BINARY_ALIGNMENT] = {};
+    out.write(zeroes, binary_padding(static_cast<std::size_t>(out.tellp())));
+}
+
+// writes a single matrix section, the payload is streamed row by row and the
+// header is rewritten with its checksum once it's known
+static void write_section(std::ostream & out, const std::string & name,
+                          const Matrix & mx, bool sparse) {
+    BinarySectionHeader header = {};
+    header.rows = mx.rows();
+    header.columns = mx.columns();
+    header.name_length = name.size();
+    std::streampos header_position = out.tellp();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(name.data(), name.size());
+    write_padding(out);
+
+    std::uint64_t checksum = binary_checksum(nullptr, 0);
+    std::uint64_t payload_size = 0;
+    auto emit = [&](const void * data, std::size_t size) {
+        out.write(static_cast<const char *>(data), size);
+        checksum = binary_checksum(data, size, checksum);
+        payload_size += size;
+    };
+
+    if (sparse) {
+        std::vector<std::uint64_t> row_offsets(mx.rows() + 1, 0);
+        std::vector<std::uint64_t> column_indices;
+        std::vector<double> values;
+        column_indices.reserve(mx.nnz());
+        values.reserve(mx.nnz());
+        mx.for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+            ++row_offsets[row + 1];
+            column_indices.push_back(column);
+            values.push_back(val);
+        });
+        for (std::size_t i = 0; i < mx.rows(); i++) {
+            row_offsets[i + 1] += row_offsets[i];
+        }
+        emit(row_offsets.data(), row_offsets.size() * sizeof(std::uint64_t));
+        emit(column_indices.data(),
+             column_indices.size() * sizeof(std::uint64_t));
+        emit(values.data(), values.size() * sizeof(double));
+        header.kind = static_cast<std::uint32_t>(BinarySection::COMPRESSED);
+        header.nnz = values.size();
+    } else {
+        // rows are laid out like in DenseMatrix, so they can be copied back
+        // in one go
+        std::size_t stride = DenseMatrix::stride_for(mx.columns());
+        std::vector<double> row_data(stride, 0);
+        std::size_t written_rows = 0;
+        auto write_rows_until = [&](std::size_t end) {
+            for (; written_rows < end; written_rows++) {
+                emit(row_data.data(), stride * sizeof(double));
+                std::fill(row_data.begin(), row_data.end(), 0);
+            }
+        };
+        mx.for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+            write_rows_until(row);
+            row_data[column] = val;
+            ++header.nnz;
+        });
+        write_rows_until(mx.rows());
+        header.kind = static_cast<std::uint32_t>(BinarySection::DENSE);
+        header.stride = stride;
     }
-    for (const auto & [pos, val] : mx){
-        data_vec[pos.row][pos.column] = val;
+    header.payload_size = payload_size;
+    header.checksum = checksum;
+    write_padding(out);
+
+    std::streampos end_position = out.tellp();
+    out.seekp(header_position);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.seekp(end_position);
+}
+
+static void write_binary(std::ostream & out,
+                         const std::unordered_map<std::string, Matrix> & vars,
+                         double ratio) {
+    BinaryFileHeader header = {};
+    std::copy(std::begin(BINARY_MAGIC), std::end(BINARY_MAGIC), header.magic);
+    header.version = BINARY_VERSION;
+    header.byte_order = BINARY_BYTE_ORDER;
+    header.matrices = vars.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto & [key, matrix] : vars) {
+        write_section(out, key, matrix, export_as_sparse(matrix, ratio));
     }
-    file[name]["data"].emplace("array", data_vec);
+}
+
+// appends sections to a binary file, the number of matrices in the header
+// is updated last, so an interrupted update leaves the file readable
+static void append_binary(const std::unordered_map<std::string, Matrix> & vars,
+                          const std::string & filename, double ratio) {
+    std::fstream file(filename,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Couldn't open file: " + filename);
+    }
+    BinaryFileHeader header = {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, BINARY_MAGIC,
+                             sizeof(BINARY_MAGIC)) != 0 ||
+        header.version != BINARY_VERSION ||
+        header.byte_order != BINARY_BYTE_ORDER) {
+        throw std::runtime_error("Cannot update file: " + filename);
+    }
+    file.seekp(0, std::ios::end);
+    write_padding(file);
+    for (const Variable * var : sorted_variables(vars)) {
+        write_section(file, var->first, var->second,
+                      export_as_sparse(var->second, ratio));
+    }
+    header.matrices += vars.size();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (file.fail() || file.bad()) {
+        throw std::runtime_error("An error occured while writing data.");
+    }
+}
+
+// an entry of an updated file, a member of a JSON object or a binary section
+struct FileEntry {
+    std::string name;
+    std::size_t begin;
+    std::size_t end;
+};
+
+// finds the members of the top-level object of a JSON file, values are
+// skipped by their brackets and strings, nothing is parsed
+static std::vector<FileEntry> scan_json(const MappedFile & file) {
+    const char * data = reinterpret_cast<const char *>(file.data());
+    std::size_t size = file.size();
+    auto malformed = [] { return std::runtime_error("Malformed JSON file."); };
+    // returns the index past the closing quote of the string at index
+    auto skip_string = [&](std::size_t index) {
+        for (++index; index < size; ++index) {
+            if (data[index] == '\\') {
+                ++index;
+            } else if (data[index] == '"') {
+                return index + 1;
+            }
+        }
+        throw malformed();
+    };
+    auto is_space = [&](std::size_t index) {
+        return std::isspace(static_cast<unsigned char>(data[index]));
+    };
+
+    std::size_t i = 0;
+    while (i < size && is_space(i)) {
+        ++i;
+    }
+    if (i == size || data[i] != '{') {
+        throw malformed();
+    }
+    ++i;
+    std::vector<FileEntry> members;
+    while (true) {
+        while (i < size && (is_space(i) || data[i] == ',')) {
+            ++i;
+        }
+        if (i == size || data[i] != '"') {
+            if (i < size && data[i] == '}') {
+                return members;
+            }
+            throw malformed();
+        }
+        std::size_t begin = i;
+        i = skip_string(i);
+        std::string name(data + begin + 1, i - begin - 2);
+        // the value ends by a comma or a brace outside of nested values
+        std::size_t depth = 0;
+        std::size_t end = i;
+        for (; i < size; ++i) {
+            char c = data[i];
+            if (c == '"') {
+                i = skip_string(i);
+                end = i--;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (!depth) {
+                    break;
+                }
+                --depth;
+            } else if (c == ',' && !depth) {
+                break;
+            }
+            if (!is_space(i)) {
+                end = i + 1;
+            }
+        }
+        members.push_back({std::move(name), begin, end});
+    }
+}
+
+// finds the sections of a binary file, from their headers to the ends of
+// their payloads
+static std::vector<FileEntry> scan_binary(const MappedFile & file) {
+    auto truncated = [] {
+        return std::runtime_error("Unexpected end of binary file.");
+    };
+    BinaryFileHeader header;
+    if (file.size() < sizeof(header)) {
+        throw truncated();
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    std::vector<FileEntry> sections;
+    std::size_t offset = sizeof(header);
+    for (std::uint64_t i = 0; i < header.matrices; i++) {
+        BinarySectionHeader section;
+        if (file.size() - offset < sizeof(section)) {
+            throw truncated();
+        }
+        std::memcpy(&section, file.data() + offset, sizeof(section));
+        std::size_t begin = offset;
+        offset += sizeof(section);
+        if (file.size() - offset < section.name_length) {
+            throw truncated();
+        }
+        std::string name(reinterpret_cast<const char *>(file.data()) + offset,
+                         section.name_length);
+        offset += section.name_length;
+        offset += binary_padding(offset);
+        if (offset > file.size() ||
+            file.size() - offset < section.payload_size) {
+            throw truncated();
+        }
+        offset += section.payload_size;
+        sections.push_back({std::move(name), begin, offset});
+        offset += std::min(binary_padding(offset), file.size() - offset);
+    }
+    return sections;
+}
+
+// the last entry of every name, in the order of the file
+static std::vector<const FileEntry *>
+live_entries(const std::vector<FileEntry> & entries) {
+    std::unordered_map<std::string, const FileEntry *> last;
+    for (const auto & entry : entries) {
+        last.insert_or_assign(entry.name, &entry);
+    }
+    std::vector<const FileEntry *> live;
+    for (const auto & entry : entries) {
+        if (last.at(entry.name) == &entry) {
+            live.push_back(&entry);
+        }
+    }
+    return live;
+}
+
+static void write_compacted_json(std::ostream & out, const MappedFile & file,
+                                 const std::vector<const FileEntry *> & live,
+                                 bool compact) {
+    const char * data = reinterpret_cast<const char *>(file.data());
+    out << '{';
+    for (std::size_t i = 0; i < live.size(); i++) {
+        out << (i ? "," : "") << (compact ? "" : "\n   ");
+        out.write(data + live[i]->begin, live[i]->end - live[i]->begin);
+    }
+    out << (compact ? "}" : "\n}");
+}
+
+// sections are copied with their checksums, only the padding before their
+// payloads is recomputed
+static void write_compacted_binary(std::ostream & out,
+                                   const MappedFile & file,
+                                   const std::vector<const FileEntry *> & live) {
+    BinaryFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    header.matrices = live.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const FileEntry * entry : live) {
+        const char * section = reinterpret_cast<const char *>(file.data()) +
+                               entry->begin;
+        std::size_t header_size =
+            sizeof(BinarySectionHeader) + entry->name.size();
+        BinarySectionHeader section_header;
+        std::memcpy(&section_header, section, sizeof(section_header));
+        out.write(section, header_size);
+        write_padding(out);
+        out.write(section + entry->end - entry->begin -
+                      section_header.payload_size,
+                  section_header.payload_size);
+        write_padding(out);
+    }
+}
+
+// updates append entries, once stale ones outnumber the live ones, the file
+// is rewritten with only the last entry of every name
+static void compact_if_stale(const std::string & filename, bool binary,
+                             bool compact) {
+    std::string compacted = filename + ".compacted";
+    {
+        MappedFile file(filename);
+        auto entries = binary ? scan_binary(file) : scan_json(file);
+        auto live = live_entries(entries);
+        if (entries.size() - live.size() <= live.size()) {
+            return;
+        }
+        std::ofstream out(compacted, std::ios::binary);
+        if (binary) {
+            write_compacted_binary(out, file, live);
+        } else {
+            write_compacted_json(out, file, live, compact);
+        }
+        if (!out.is_open() || out.fail() || out.bad()) {
+            throw std::runtime_error("An error occured while writing data.");
+        }
+    }
+    std::filesystem::rename(compacted, filename);
 }
 
 void Exporter::export_to_file(const std::unordered_map<std::string, Matrix> & vars,
                               const std::string & filename) {
     reset();
-    std::ofstream outfile(filename);
+    bool binary = is_binary_file(filename);
+    if (!binary && _options.sharded) {
+        try {
+            export_shards(vars, filename);
+            _status = "Write to " + filename + " finished successfully.";
+        } catch (std::exception & e) {
+            _status = e.what();
+            _is_failed = true;
+        }
+        return;
+    }
+
+    std::ofstream outfile(filename, binary ? std::ios::out | std::ios::binary
+                                           : std::ios::out);
     if (!outfile.is_open() || outfile.bad()){
         _status = "Couldn't open file: " + filename;
         _is_failed = true;
         return;
     }
 
-    json out_data;
-    for (const auto & [key, matrix] : vars){
-        out_data[key].emplace("rows", matrix.rows());
-        out_data[key].emplace("columns", matrix.columns());
-
-        std::size_t number_of_non_zeroes = matrix.begin().distance(matrix.end());
-        std::size_t max_non_zeroes = (1 - _factory.ratio()) * matrix.rows() * matrix.columns();
-
-        out_data[key]["data"];
-        if (number_of_non_zeroes < max_non_zeroes){
-            write_sparse(out_data, key, matrix);
-        } else {
-            write_dense(out_data, key, matrix);
-        }
+    if (binary) {
+        write_binary(outfile, vars, _factory.ratio());
+    } else {
+        write_json(outfile, sorted_variables(vars), _factory.ratio(),
+                   _options.compact, _factory.pool());
     }
-    outfile << std::setw(3) << out_data;
     if (!outfile.is_open() || outfile.fail() || outfile.bad()){
         _status = "An error occured while writing data.";
         _is_failed = true;
@@ -60,4 +761,37 @@ void Exporter::export_to_file(const std::unordered_map<std::string, Matrix> & va
         _status = "Write to " + filename + " finished successfully.";
         _is_failed = false;
     }
-}
\ No newline at end of file
+}
+void Exporter::update_file(const std::unordered_map<std::string, Matrix> & vars,
+                           const std::unordered_set<std::string> & dirty,
+                           const std::string & filename) {
+    if (!std::filesystem::exists(filename)) {
+        export_to_file(vars, filename);
+        return;
+    }
+    reset();
+    std::unordered_map<std::string, Matrix> changed;
+    for (const auto & name : dirty) {
+        if (vars.count(name)) {
+            changed.emplace(name, vars.at(name));
+        }
+    }
+    try {
+        if (is_binary_file(filename)) {
+            append_binary(changed, filename, _factory.ratio());
+            compact_if_stale(filename, true, _options.compact);
+        } else if (_options.sharded) {
+            update_shards(changed, filename);
+        } else {
+            append_json(changed, filename, _factory.ratio(), _options.compact,
+                        _factory.pool());
+            compact_if_stale(filename, false, _options.compact);
+        }
+    } catch (std::exception & e) {
+        _status = e.what();
+        _is_failed = true;
+        return;
+    }
+    _status = "Update of " + filename + " finished successfully, " +
+              std::to_string(changed.size()) + " variable(s) written.";
+}
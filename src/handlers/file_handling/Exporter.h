@@ -2,11 +2,34 @@
 
 #include "../../matrix_wrapper/Matrix.h"
 #include "FileHandler.h"
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+
+/**
+ * @brief Options of JSON exports.
+ */
+struct ExportOptions {
+
+    /**
+     * @brief Writes JSON without indentation and line breaks.
+     */
+    bool compact = false;
+
+    /**
+     * @brief Writes every variable into its own file. The exported file
+     *        becomes a manifest mapping names of the variables to their
+     *        files, which can be imported as any other file.
+     */
+    bool sharded = false;
+};
 
 /**
  * @brief Class serving as a way to export matrices to files. Exports matrices
- *        to JSON files.
+ *        to JSON files, or to binary files described in <b>BinaryFormat.h</b>
+ *        if the filename ends with <b>.bmx</b>. JSON is streamed into the
+ *        file, variables are serialized in parallel on the factory's thread
+ *        pool.
  */
 class Exporter : public FileHandler {
   public:
@@ -15,14 +38,62 @@ class Exporter : public FileHandler {
      * @brief Initializes the parent Exporter and it's parent.
      * @param factory Factory used for determining the format for exporting a
      *                certain matrix.
+     * @param options Options of JSON exports.
      */
-    Exporter(MatrixFactory factory);
+    Exporter(MatrixFactory factory, ExportOptions options = {});
 
     /**
-     * @brief Exports matrices to a JSON file.
+     * @brief Exports matrices to a JSON or a binary file, depending on the
+     *        extension of <b>filename</b>.
      * @param vars A container of variables to export.
      * @param filename Name of the resulting file.
      */
     void export_to_file(const std::unordered_map<std::string, Matrix> & vars,
                         const std::string & filename);
+
+    /**
+     * @brief Writes changed variables into an existing file, the rest of the
+     *        file is kept. Sections are appended to binary files and members
+     *        to JSON files, both are resolved by importing the last entry of
+     *        every name. Once the replaced entries outnumber the current
+     *        ones, the file is rewritten with only the last entry of every
+     *        name. Manifests of sharded exports get only the shards of
+     *        the changed variables rewritten. If the file doesn't exist yet,
+     *        all of <b>vars</b> are exported into it.
+     * @param vars A container of the variables kept in the file.
+     * @param dirty Names of the variables changed since the file was written.
+     * @param filename Name of the file to update.
+     */
+    void update_file(const std::unordered_map<std::string, Matrix> & vars,
+                     const std::unordered_set<std::string> & dirty,
+                     const std::string & filename);
+
+  private:
+
+    /**
+     * @brief Options of JSON exports.
+     */
+    ExportOptions _options;
+
+    /**
+     * @brief Writes every variable into its own JSON file next to
+     *        <b>filename</b> and a manifest listing them into <b>filename</b>.
+     * @param vars A container of variables to export.
+     * @param filename Name of the manifest.
+     * @throws std::runtime_error if a file can't be written.
+     */
+    void export_shards(const std::unordered_map<std::string, Matrix> & vars,
+                       const std::string & filename) const;
+
+    /**
+     * @brief Rewrites the shards of <b>vars</b> listed in the manifest
+     *        <b>filename</b>, adds shards of new variables and rewrites the
+     *        manifest.
+     * @param vars Variables to write.
+     * @param filename Name of the manifest.
+     * @throws std::runtime_error if the file isn't a manifest or if a file
+     *                            can't be written.
+     */
+    void update_shards(const std::unordered_map<std::string, Matrix> & vars,
+                       const std::string & filename) const;
 };
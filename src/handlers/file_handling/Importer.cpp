@@ -1,142 +1,283 @@
 #include "Importer.h"
 #include "../../../libs/json.hpp"
-#include "../../iterators/DenseMatrixIterator.h"
-#include "../../iterators/SparseMatrixIterator.h"
+#include "../../parallel/ThreadPool.h"
+#include "../../representations/DenseMatrix.h"
+#include "BinaryFormat.h"
+#include "MappedFile.h"
+#include "MatrixSaxHandler.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 using json = nlohmann::json;
 
+static_assert(sizeof(std::size_t) == sizeof(std::uint64_t),
+              "Compressed payloads are copied into std::size_t arrays.");
+
 Importer::Importer(MatrixFactory factory) : FileHandler(factory) {}
 
-static bool check_contents(const json & json_file,
-                           const std::string & mx_name) {
-    if (!json_file[mx_name].contains("rows") ||
-        !json_file[mx_name].contains("columns") ||
-        !json_file[mx_name].contains("data")) {
-        return false;
-    }
-    if (!json_file[mx_name]["rows"].is_number() ||
-        !json_file[mx_name]["columns"].is_number()) {
-        return false;
-    }
-    if (json_file[mx_name]["data"].contains("array") &&
-        !json_file[mx_name]["data"]["array"].is_array()) {
-        return false;
-    } else if (!json_file[mx_name]["data"].contains("array") &&
-               !json_file[mx_name]["data"].is_null()) {
-        for (const auto & [key, val] : json_file[mx_name]["data"].items()) {
-            if (!json_file[mx_name]["data"][key].is_number()) {
-                return false;
-            }
+const std::vector<std::string> & Importer::imported() const {
+    return _imported;
+}
+
+// copies a value from the file at offset and moves past it
+template <typename T>
+static T read_value(const MappedFile & file, std::size_t & offset) {
+    if (file.size() - offset < sizeof(T)) {
+        throw std::runtime_error("Unexpected end of binary file.");
+    }
+    T value;
+    std::memcpy(&value, file.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+static void skip_bytes(const MappedFile & file, std::size_t & offset,
+                       std::size_t count) {
+    if (file.size() - offset < count) {
+        throw std::runtime_error("Unexpected end of binary file.");
+    }
+    offset += count;
+}
+
+static Matrix read_dense_section(const BinarySectionHeader & header,
+                                 const unsigned char * payload,
+                                 MatrixFactory factory) {
+    std::size_t words = header.payload_size / sizeof(double);
+    if (header.stride < header.columns || words % header.stride ||
+        words / header.stride != header.rows) {
+        throw std::runtime_error("Invalid size of dense data.");
+    }
+    std::size_t stride = DenseMatrix::stride_for(header.columns);
+    DenseMatrix::Buffer data(header.rows * stride);
+    if (stride == header.stride) {
+        std::memcpy(data.data(), payload, header.payload_size);
+    } else {
+        for (std::size_t i = 0; i < header.rows; i++) {
+            std::memcpy(data.data() + i * stride,
+                        payload + i * header.stride * sizeof(double),
+                        header.columns * sizeof(double));
         }
     }
-    return true;
+    return Matrix(header.rows, header.columns, std::move(data), factory);
 }
 
-Matrix read_dense(json & json_data, const std::string & name,
-                  const MatrixDimensions & dims,
-                  const MatrixFactory & factory) {
-    std::vector<std::vector<double>> mx_data(dims.rows());
-    for (auto & row : mx_data) {
-        row.resize(dims.columns());
-    }
-    mx_data = json_data[name]["data"]["array"]
-                  .get<std::vector<std::vector<double>>>();
-    if (mx_data.size() != dims.rows()){
-        throw std::runtime_error("Invalid array dimensions in matrix.");
-    }
-    for (const auto & row : mx_data){
-        if (row.size() != dims.columns()){
-            throw std::runtime_error("Invalid array dimensions in matrix,");
+static Matrix read_compressed_section(const BinarySectionHeader & header,
+                                      const unsigned char * payload,
+                                      MatrixFactory factory) {
+    std::size_t words = header.payload_size / sizeof(std::uint64_t);
+    if (header.rows >= words || header.nnz > words / 2 ||
+        header.rows + 1 + 2 * header.nnz != words) {
+        throw std::runtime_error("Invalid size of compressed data.");
+    }
+    std::vector<std::size_t> row_offsets(header.rows + 1);
+    std::vector<std::size_t> column_indices(header.nnz);
+    std::vector<double> values(header.nnz);
+    std::memcpy(row_offsets.data(), payload,
+                row_offsets.size() * sizeof(std::uint64_t));
+    payload += row_offsets.size() * sizeof(std::uint64_t);
+    std::memcpy(column_indices.data(), payload,
+                column_indices.size() * sizeof(std::uint64_t));
+    payload += column_indices.size() * sizeof(std::uint64_t);
+    std::memcpy(values.data(), payload, values.size() * sizeof(double));
+
+    // the arrays are adopted as they are, so they have to be well formed
+    if (row_offsets.front() != 0 || row_offsets.back() != header.nnz) {
+        throw std::runtime_error("Invalid compressed data.");
+    }
+    for (std::size_t i = 0; i < header.rows; i++) {
+        if (row_offsets[i] > row_offsets[i + 1] ||
+            row_offsets[i + 1] > header.nnz) {
+            throw std::runtime_error("Invalid compressed data.");
+        }
+        for (std::size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+            if (column_indices[k] >= header.columns || values[k] == 0 ||
+                (k > row_offsets[i] &&
+                 column_indices[k - 1] >= column_indices[k])) {
+                throw std::runtime_error("Invalid compressed data.");
+            }
         }
     }
+    return Matrix(header.rows, header.columns, std::move(row_offsets),
+                  std::move(column_indices), std::move(values), factory);
+}
 
-    return {{new DenseMatrixIterator(&dims, mx_data, 0, 0)},
-            {new DenseMatrixIterator(&dims, mx_data, dims.rows(), 0)},
-            factory};
+// verifies and builds a single section
+static Matrix read_section(const BinarySectionHeader & section,
+                           const std::string & name,
+                           const unsigned char * payload,
+                           MatrixFactory factory) {
+    if (binary_checksum(payload, section.payload_size) != section.checksum) {
+        throw std::runtime_error("Checksum mismatch in matrix: " + name);
+    }
+    if (!section.rows || !section.columns) {
+        throw std::runtime_error("Invalid dimensions of matrix: " + name);
+    }
+    try {
+        if (section.payload_size % sizeof(std::uint64_t)) {
+            throw std::runtime_error("Invalid size of matrix data.");
+        }
+        switch (static_cast<BinarySection>(section.kind)) {
+        case BinarySection::DENSE:
+            return read_dense_section(section, payload, factory);
+        case BinarySection::COMPRESSED:
+            return read_compressed_section(section, payload, factory);
+        default:
+            throw std::runtime_error("Unknown kind of matrix data.");
+        }
+    } catch (std::exception & e) {
+        throw std::runtime_error("An error occurred while reading matrix: " +
+                                 name + '\n' + e.what());
+    }
 }
 
-Matrix read_sparse(json & json_data, const std::string & name,
-                   const MatrixDimensions & dims,
-                   const MatrixFactory & factory) {
-    std::map<Position, double> mx_data;
-    for (const auto & [key, val] : json_data[name]["data"].items()) {
-        std::stringstream oss(key);
-        std::size_t row, col;
-        char c;
-
-        double value_at_key = json_data[name]["data"][key].get<double>();
-        if (value_at_key == 0){
+// reads the matrices of a mapped binary file; sections are indexed first,
+// so only the last section of every selected name is built, payloads are
+// verified by their checksums and copied straight into the arrays adopted
+// by the matrices in parallel
+static void read_binary(const MappedFile & file, MatrixFactory factory,
+                        const std::unordered_set<std::string> & selected,
+                        std::unordered_map<std::string, Matrix> & out) {
+    std::size_t offset = 0;
+    auto header = read_value<BinaryFileHeader>(file, offset);
+    if (std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+        throw std::runtime_error("Not a binary matrix file.");
+    }
+    if (header.byte_order != BINARY_BYTE_ORDER) {
+        throw std::runtime_error("Binary file uses a different byte order.");
+    }
+    if (header.version != BINARY_VERSION) {
+        throw std::runtime_error("Unsupported version of binary file: " +
+                                 std::to_string(header.version));
+    }
+    std::vector<BinarySectionHeader> sections;
+    std::vector<std::string> names;
+    std::vector<const unsigned char *> payloads;
+    std::unordered_map<std::string, std::size_t> last_section;
+    for (std::uint64_t i = 0; i < header.matrices; i++) {
+        auto section = read_value<BinarySectionHeader>(file, offset);
+        std::size_t name_offset = offset;
+        skip_bytes(file, offset, section.name_length);
+        std::string name(reinterpret_cast<const char *>(file.data()) +
+                             name_offset,
+                         section.name_length);
+        skip_bytes(file, offset, binary_padding(offset));
+        const unsigned char * payload = file.data() + offset;
+        skip_bytes(file, offset, section.payload_size);
+        skip_bytes(file, offset, binary_padding(offset));
+        if (!selected.empty() && !selected.count(name)) {
             continue;
         }
-        if (!(oss >> row) || !(oss >> c) || c != ':' || !(oss >> col)) {
-            throw std::runtime_error("Unknown key: " + key);
+        // updates append sections, later ones replace earlier ones
+        last_section.insert_or_assign(name, sections.size());
+        sections.push_back(section);
+        names.push_back(std::move(name));
+        payloads.push_back(payload);
+    }
+
+    std::vector<std::size_t> built;
+    for (std::size_t i = 0; i < sections.size(); i++) {
+        if (last_section.at(names[i]) == i) {
+            built.push_back(i);
         }
-        if (row >= dims.rows() || col >= dims.columns()) {
-            throw std::runtime_error("Unknown position: " + key);
+    }
+    std::vector<std::optional<Matrix>> matrices(built.size());
+    parallel_for(factory.pool(), 0, built.size(), 1,
+                 [&](std::size_t first, std::size_t last) {
+        for (std::size_t k = first; k < last; k++) {
+            std::size_t i = built[k];
+            matrices[k].emplace(
+                read_section(sections[i], names[i], payloads[i], factory));
         }
-        mx_data[{row, col}] = value_at_key;
+    });
+    for (std::size_t k = 0; k < built.size(); k++) {
+        out.insert_or_assign(names[built[k]], std::move(*matrices[k]));
     }
-    return {{new SparseMatrixIterator(&dims, mx_data.begin(), mx_data.end())},
-            {new SparseMatrixIterator(&dims, mx_data.end(), mx_data.end())},
-            factory};
 }
 
-void Importer::import_from_file(std::unordered_map<std::string, Matrix> & vars,
-                                const std::string & filename) {
-    reset();
-    std::unordered_map<std::string, Matrix> loaded_matrices;
+using Shards = std::vector<std::pair<std::string, std::string>>;
+
+// parses a JSON file into out, matrices are built while the file is parsed,
+// the document itself is never stored; returns the shards listed in it
+static Shards read_json(const std::string & filename, MatrixFactory factory,
+                        bool allow_shards,
+                        const std::unordered_set<std::string> & selected,
+                        std::unordered_map<std::string, Matrix> & out) {
     std::ifstream infile(filename);
     if (!infile.is_open() || infile.fail() || infile.bad()) {
-        _status = "Couldn't open file: " + filename;
-        _is_failed = true;
-        return;
+        throw std::runtime_error("Couldn't open file: " + filename);
     }
-
-    json input_data;
-    try {
-        input_data = json::parse(infile);
-    } catch (std::exception & e) {
-        _status = "An error occurred during json parsing.";
-        _is_failed = true;
-        return;
+    MatrixSaxHandler handler(factory, allow_shards, selected);
+    if (!json::sax_parse(infile, &handler)) {
+        throw std::runtime_error(handler.error());
     }
+    out = std::move(handler.matrices());
+    return handler.shards();
+}
 
-    for (const auto & [key, data] : input_data.items()) {
-        if (!check_contents(input_data, key)) {
-            _status = "Error while reading data of matrix: " + key;
-            _is_failed = true;
-            return;
+// loads the shards of a manifest in parallel, shard filenames are relative
+// to the manifest
+static void read_shards(const std::string & manifest, const Shards & shards,
+                        MatrixFactory factory,
+                        std::unordered_map<std::string, Matrix> & out) {
+    std::filesystem::path directory =
+        std::filesystem::path(manifest).parent_path();
+    std::vector<std::unordered_map<std::string, Matrix>> loaded(shards.size());
+    parallel_for(factory.pool(), 0, shards.size(), 1,
+                 [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            std::string path = (directory / shards[i].second).string();
+            if (is_binary_file(path)) {
+                MappedFile file(path);
+                read_binary(file, factory, {shards[i].first}, loaded[i]);
+            } else {
+                read_json(path, factory, false, {shards[i].first}, loaded[i]);
+            }
+            if (!loaded[i].count(shards[i].first)) {
+                throw std::runtime_error("Matrix " + shards[i].first +
+                                         " is missing in shard: " + path);
+            }
         }
+    });
+    for (std::size_t i = 0; i < shards.size(); i++) {
+        out.insert_or_assign(shards[i].first,
+                             std::move(loaded[i].at(shards[i].first)));
+    }
+}
 
-        std::size_t rows = input_data[key]["rows"].get<std::size_t>();
-        std::size_t columns = input_data[key]["columns"].get<std::size_t>();
-        if (!rows || !columns) {
-            _status = "Invalid dimensions of matrix: " + key;
-            _is_failed = true;
-            return;
+void Importer::import_from_file(std::unordered_map<std::string, Matrix> & vars,
+                                const std::string & filename,
+                                const std::vector<std::string> & names) {
+    reset();
+    _imported.clear();
+    std::unordered_set<std::string> selected(names.begin(), names.end());
+    std::unordered_map<std::string, Matrix> loaded_matrices;
+    try {
+        if (is_binary_file(filename)) {
+            MappedFile file(filename);
+            read_binary(file, _factory, selected, loaded_matrices);
+        } else {
+            Shards shards =
+                read_json(filename, _factory, true, selected, loaded_matrices);
+            read_shards(filename, shards, _factory, loaded_matrices);
         }
-        try {
-            if (input_data[key]["data"].is_null()) {
-                loaded_matrices.emplace(key, Matrix(rows, columns, _factory));
-                continue;
-            } else if (input_data[key]["data"].contains("array")) {
-                loaded_matrices.emplace(
-                    key,
-                    read_dense(input_data, key, {rows, columns}, _factory));
-            } else {
-                loaded_matrices.emplace(
-                    key,
-                    read_sparse(input_data, key, {rows, columns}, _factory));
+        for (const auto & name : names) {
+            if (!loaded_matrices.count(name)) {
+                throw std::runtime_error("Matrix " + name +
+                                         " not found in file: " + filename);
             }
-        } catch (std::exception & e) {
-            _status = "An error occurred while reading matrix: " + key + '\n';
-            _status += e.what();
-            _is_failed = true;
-            return;
         }
+    } catch (std::exception & e) {
+        _status = e.what();
+        _is_failed = true;
+        return;
     }
     for (auto & [key, val] : loaded_matrices){
         if (vars.count(key)){
@@ -144,6 +285,7 @@ void Importer::import_from_file(std::unordered_map<std::string, Matrix> & vars,
         }
         vars.erase(key);
         vars.emplace(key, val);
+        _imported.push_back(key);
     }
     _status += "Import from file " + filename + " successfully finished";
 }
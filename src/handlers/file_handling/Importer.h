@@ -5,9 +5,11 @@
 #include "FileHandler.h"
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 /**
- * @brief Class providing tools to import matrices from JSON files.
+ * @brief Class providing tools to import matrices from JSON files and from
+ *        binary files described in <b>BinaryFormat.h</b>.
  */
 class Importer : public FileHandler {
   public:
@@ -20,11 +22,32 @@ class Importer : public FileHandler {
     Importer(MatrixFactory factory);
 
     /**
-     * @brief Imports matrices from a JSON file specified by <b>filename</b>.
+     * @brief Imports matrices from a file specified by <b>filename</b>. Files
+     *        ending with <b>.bmx</b> are memory mapped and read as binary
+     *        files, other files are parsed as JSON. Shards listed in
+     *        manifests of sharded exports are loaded in parallel.
      * @param[out] out_vars Container, into which the imported matrices
      *                      will be loaded.
      * @param filename Name of the file to import from.
+     * @param names Names of the matrices to import, others are skipped.
+     *              Empty to import all matrices of the file. The import
+     *              fails if one of them isn't found.
      */
     void import_from_file(std::unordered_map<std::string, Matrix> & out_vars,
-                          const std::string & filename);
+                          const std::string & filename,
+                          const std::vector<std::string> & names = {});
+
+    /**
+     * @brief Getter for the names of the matrices loaded by the last
+     *        successful import.
+     * @return Names of the imported matrices.
+     */
+    const std::vector<std::string> & imported() const;
+
+  private:
+
+    /**
+     * @brief Names of the matrices loaded by the last import.
+     */
+    std::vector<std::string> _imported;
 };
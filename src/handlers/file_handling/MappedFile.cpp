@@ -0,0 +1,37 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string & filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Couldn't open file: " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        throw std::runtime_error("Couldn't open file: " + filename);
+    }
+    _size = static_cast<std::size_t>(info.st_size);
+    if (_size) {
+        void * mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Couldn't map file: " + filename);
+        }
+        // matrices are read front to back exactly once
+        madvise(mapping, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const unsigned char *>(mapping);
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        munmap(const_cast<unsigned char *>(_data), _size);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A read-only memory mapping of a whole file. The file is mapped on
+ *        construction and unmapped on destruction, pages are loaded by the
+ *        kernel as they are read.
+ */
+class MappedFile {
+  public:
+    MappedFile() = delete;
+
+    /**
+     * @brief Maps the file specified by <b>filename</b> for reading.
+     * @param filename Name of the file to map.
+     * @throws std::runtime_error if the file can't be opened or mapped.
+     */
+    explicit MappedFile(const std::string & filename);
+
+    MappedFile(const MappedFile & src) = delete;
+
+    MappedFile & operator=(const MappedFile & src) = delete;
+
+    ~MappedFile();
+
+    /**
+     * @brief Getter for the contents of the file.
+     * @return Pointer to the first byte of the file, nullptr if it's empty.
+     */
+    const unsigned char * data() const { return _data; }
+
+    /**
+     * @brief Getter for the size of the file.
+     * @return Size of the file in bytes.
+     */
+    std::size_t size() const { return _size; }
+
+  private:
+
+    /**
+     * @brief Start of the mapping, nullptr for empty files.
+     */
+    const unsigned char * _data = nullptr;
+
+    /**
+     * @brief Size of the mapping in bytes.
+     */
+    std::size_t _size = 0;
+};
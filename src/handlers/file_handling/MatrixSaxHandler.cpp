@@ -0,0 +1,415 @@
+#include "MatrixSaxHandler.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+MatrixSaxHandler::MatrixSaxHandler(MatrixFactory factory, bool allow_shards,
+                                   std::unordered_set<std::string> selected)
+    : _factory(factory), _allow_shards(allow_shards),
+      _selected(std::move(selected)) {}
+
+bool MatrixSaxHandler::is_selected() const {
+    return _selected.empty() || _selected.count(_name);
+}
+
+static const char * skip_whitespace(const char * first, const char * last) {
+    while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+        ++first;
+    }
+    return first;
+}
+
+// parses keys of sparse data in the "row:column" format, whitespace may
+// precede the row, the colon and the column, anything past the column is
+// ignored
+static bool parse_position(const std::string & key, std::size_t & row,
+                           std::size_t & column) {
+    const char * last = key.data() + key.size();
+    const char * first = skip_whitespace(key.data(), last);
+    auto [row_end, row_error] = std::from_chars(first, last, row);
+    if (row_error != std::errc()) {
+        return false;
+    }
+    const char * colon = skip_whitespace(row_end, last);
+    if (colon == last || *colon != ':') {
+        return false;
+    }
+    first = skip_whitespace(colon + 1, last);
+    auto [column_end, column_error] = std::from_chars(first, last, column);
+    return column_error == std::errc();
+}
+
+// converts a dimension read from the file, values which aren't integers
+// representable by std::size_t are invalid and converted to 0
+static std::size_t to_dimension(double value) {
+    // the maximum rounds up to 2^64 as a double, which is out of range
+    constexpr auto limit =
+        static_cast<double>(std::numeric_limits<std::size_t>::max());
+    if (!(value >= 0) || value >= limit || std::trunc(value) != value) {
+        return 0;
+    }
+    return static_cast<std::size_t>(value);
+}
+
+MatrixSaxHandler::Slot MatrixSaxHandler::slot() const {
+    switch (_depth) {
+    case 0:
+        return Slot::TOP;
+    case 1:
+        return Slot::MATRIX;
+    case 2:
+        if (_key == "rows") {
+            return Slot::ROWS;
+        } else if (_key == "columns") {
+            return Slot::COLUMNS;
+        } else if (_key == "data") {
+            return Slot::DATA;
+        }
+        return Slot::IGNORED;
+    case 3:
+        return _data_key == "array" ? Slot::ARRAY : Slot::ELEMENT;
+    case 4:
+        return Slot::ROW;
+    case 5:
+        return Slot::VALUE;
+    default:
+        return Slot::NESTED;
+    }
+}
+
+void MatrixSaxHandler::fail_read(const std::string & message) {
+    if (_pending.read_error.empty()) {
+        _pending.read_error = message;
+    }
+    _pending.data = DenseMatrix::Buffer();
+}
+
+bool MatrixSaxHandler::scalar(std::optional<double> number, bool is_null) {
+    if (_skip_depth) {
+        return true;
+    }
+    switch (slot()) {
+    case Slot::TOP:
+    case Slot::MATRIX:
+        _error = _depth ? "Error while reading data of matrix: " + _name
+                        : "An error occurred during json parsing.";
+        return false;
+    case Slot::ROWS:
+        _pending.rows = number;
+        _pending.check_failed |= !number;
+        break;
+    case Slot::COLUMNS:
+        _pending.columns = number;
+        _pending.check_failed |= !number;
+        break;
+    case Slot::DATA:
+        _pending.has_data = true;
+        _pending.data_is_null = is_null;
+        _pending.check_failed |= !is_null;
+        break;
+    case Slot::IGNORED:
+        break;
+    case Slot::ARRAY:
+        _pending.check_failed = true;
+        break;
+    case Slot::ELEMENT: {
+        if (!number) {
+            _pending.element_check_failed = true;
+            break;
+        }
+        std::size_t row, column;
+        if (!_pending.element_error.empty()) {
+            break;
+        }
+        // zeroes are kept, so that they replace an earlier element at the
+        // same position, but their keys aren't checked
+        if (!parse_position(_data_key, row, column)) {
+            if (*number != 0) {
+                _pending.element_error = "Unknown key: " + _data_key;
+            }
+            break;
+        }
+        _pending.elements.emplace_back(row, column, *number);
+        break;
+    }
+    case Slot::ROW:
+        fail_read("Invalid array dimensions in matrix,");
+        break;
+    case Slot::VALUE:
+        if (!number) {
+            fail_read("Invalid value in matrix array.");
+        } else if (_pending.read_error.empty()) {
+            _pending.data.emplace_back(*number);
+            ++_pending.row_length;
+        }
+        break;
+    case Slot::NESTED:
+        break;
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::null() { return scalar(std::nullopt, true); }
+
+bool MatrixSaxHandler::boolean(bool) { return scalar(std::nullopt, false); }
+
+bool MatrixSaxHandler::number_integer(number_integer_t val) {
+    return scalar(static_cast<double>(val), false);
+}
+
+bool MatrixSaxHandler::number_unsigned(number_unsigned_t val) {
+    return scalar(static_cast<double>(val), false);
+}
+
+bool MatrixSaxHandler::number_float(number_float_t val, const string_t &) {
+    return scalar(val, false);
+}
+
+bool MatrixSaxHandler::string(string_t & val) {
+    if (!_skip_depth && _depth == 1 && _allow_shards) {
+        if (is_selected()) {
+            _shards.emplace_back(_name, val);
+        }
+        return true;
+    }
+    return scalar(std::nullopt, false);
+}
+
+bool MatrixSaxHandler::binary(binary_t &) {
+    return scalar(std::nullopt, false);
+}
+
+bool MatrixSaxHandler::start_object(std::size_t) {
+    Slot current = slot();
+    ++_depth;
+    if (_skip_depth) {
+        return true;
+    }
+    switch (current) {
+    case Slot::TOP:
+        break;
+    case Slot::MATRIX:
+        _pending = PendingMatrix();
+        _key.clear();
+        // matrices, which weren't asked for, are skipped without validation
+        if (!is_selected()) {
+            _skip_depth = _depth;
+        }
+        break;
+    case Slot::DATA:
+        _pending.has_data = true;
+        _pending.data_is_null = false;
+        _data_key.clear();
+        break;
+    case Slot::IGNORED:
+        _skip_depth = _depth;
+        break;
+    case Slot::ELEMENT:
+        _pending.element_check_failed = true;
+        _skip_depth = _depth;
+        break;
+    case Slot::ROW:
+    case Slot::VALUE:
+    case Slot::NESTED:
+        fail_read("Invalid array dimensions in matrix,");
+        _skip_depth = _depth;
+        break;
+    default:
+        _pending.check_failed = true;
+        _skip_depth = _depth;
+        break;
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::key(string_t & val) {
+    if (_skip_depth) {
+        return true;
+    }
+    switch (_depth) {
+    case 1:
+        _name = val;
+        break;
+    case 2:
+        _key = val;
+        break;
+    case 3:
+        _data_key = val;
+        break;
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::end_object() {
+    --_depth;
+    if (_skip_depth) {
+        if (_depth < _skip_depth) {
+            _skip_depth = 0;
+        }
+        return true;
+    }
+    if (_depth == 1) {
+        return finish_matrix();
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::start_array(std::size_t) {
+    Slot current = slot();
+    ++_depth;
+    if (_skip_depth) {
+        return true;
+    }
+    switch (current) {
+    case Slot::TOP:
+        _error = "An error occurred during json parsing.";
+        return false;
+    case Slot::MATRIX:
+        _error = "Error while reading data of matrix: " + _name;
+        return false;
+    case Slot::ARRAY:
+        _pending.has_array = true;
+        _pending.data = DenseMatrix::Buffer();
+        _pending.array_rows = 0;
+        _pending.array_columns = 0;
+        if (_pending.columns) {
+            _pending.array_columns = to_dimension(*_pending.columns);
+        }
+        break;
+    case Slot::ROW:
+        _pending.row_length = 0;
+        break;
+    case Slot::IGNORED:
+        _skip_depth = _depth;
+        break;
+    case Slot::ELEMENT:
+        _pending.element_check_failed = true;
+        _skip_depth = _depth;
+        break;
+    case Slot::VALUE:
+    case Slot::NESTED:
+        fail_read("Invalid value in matrix array.");
+        _skip_depth = _depth;
+        break;
+    default:
+        _pending.check_failed = true;
+        _skip_depth = _depth;
+        break;
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::end_array() {
+    --_depth;
+    if (_skip_depth) {
+        if (_depth < _skip_depth) {
+            _skip_depth = 0;
+        }
+        return true;
+    }
+    // a row of the dense array ended, the first one determines the number
+    // of columns if it wasn't known yet
+    if (_depth == 4 && _pending.read_error.empty()) {
+        if (!_pending.array_rows && !_pending.array_columns) {
+            _pending.array_columns = _pending.row_length;
+        }
+        if (_pending.row_length != _pending.array_columns ||
+            !_pending.array_columns) {
+            fail_read("Invalid array dimensions in matrix,");
+            return true;
+        }
+        std::size_t stride = DenseMatrix::stride_for(_pending.array_columns);
+        _pending.data.resize(_pending.data.size() + stride -
+                             _pending.array_columns, 0);
+        ++_pending.array_rows;
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::finish_matrix() {
+    PendingMatrix pending = std::move(_pending);
+    _pending = PendingMatrix();
+    bool check_failed = pending.check_failed ||
+                        (!pending.has_array && !pending.data_is_null &&
+                         pending.element_check_failed);
+    if (!pending.rows || !pending.columns || !pending.has_data ||
+        check_failed) {
+        _error = "Error while reading data of matrix: " + _name;
+        return false;
+    }
+    std::size_t rows = to_dimension(*pending.rows);
+    std::size_t columns = to_dimension(*pending.columns);
+    if (!rows || !columns) {
+        _error = "Invalid dimensions of matrix: " + _name;
+        return false;
+    }
+    try {
+        if (pending.data_is_null) {
+            _matrices.insert_or_assign(_name, Matrix(rows, columns, _factory));
+            return true;
+        }
+        if (pending.has_array) {
+            if (!pending.read_error.empty()) {
+                throw std::runtime_error(pending.read_error);
+            }
+            if (pending.array_rows != rows) {
+                throw std::runtime_error("Invalid array dimensions in matrix.");
+            }
+            if (pending.array_columns != columns) {
+                throw std::runtime_error("Invalid array dimensions in matrix,");
+            }
+            _matrices.insert_or_assign(
+                _name, Matrix(rows, columns, std::move(pending.data), _factory));
+            return true;
+        }
+        if (!pending.element_error.empty()) {
+            throw std::runtime_error(pending.element_error);
+        }
+        // zeroes outside of the matrix don't replace anything
+        auto & elements = pending.elements;
+        elements.erase(
+            std::remove_if(elements.begin(), elements.end(),
+                           [&](const MatrixElement & element) {
+                               return element.value == 0 &&
+                                      (element.position.row >= rows ||
+                                       element.position.column >= columns);
+                           }),
+            elements.end());
+        for (const auto & [pos, val] : elements) {
+            if (pos.row >= rows || pos.column >= columns) {
+                throw std::runtime_error("Unknown position: " +
+                                         std::to_string(pos.row) + ":" +
+                                         std::to_string(pos.column));
+            }
+        }
+        _matrices.insert_or_assign(
+            _name,
+            Matrix(rows, columns, std::move(pending.elements), _factory));
+    } catch (std::exception & e) {
+        _error = "An error occurred while reading matrix: " + _name + '\n';
+        _error += e.what();
+        return false;
+    }
+    return true;
+}
+
+bool MatrixSaxHandler::parse_error(std::size_t, const std::string &,
+                                   const nlohmann::detail::exception &) {
+    _error = "An error occurred during json parsing.";
+    return false;
+}
+
+const std::string & MatrixSaxHandler::error() const { return _error; }
+
+std::unordered_map<std::string, Matrix> & MatrixSaxHandler::matrices() {
+    return _matrices;
+}
+
+const std::vector<std::pair<std::string, std::string>> &
+MatrixSaxHandler::shards() const {
+    return _shards;
+}
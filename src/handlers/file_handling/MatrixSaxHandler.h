@@ -0,0 +1,217 @@
+#pragma once
+
+#include "../../../libs/json.hpp"
+#include "../../matrix_wrapper/Matrix.h"
+#include "../../matrix_wrapper/MatrixFactory.h"
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A SAX handler building matrices from a JSON file while it's being
+ *        parsed, so the document is never held in memory as a whole. The
+ *        expected format is the one written by <b>Exporter</b>: an object
+ *        mapping names to objects with <b>rows</b>, <b>columns</b> and
+ *        <b>data</b>, where data is either null, <b>{"array": [[...]]}</b>
+ *        or an object mapping <b>"row:column"</b> keys to values. Elements
+ *        are written straight into the buffers adopted by the matrices, the
+ *        keys of matrix objects may come in any order. Parsing stops at the
+ *        first invalid matrix. Manifests of sharded exports map names to
+ *        filenames instead, those are collected as shards.
+ */
+class MatrixSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+  public:
+    MatrixSaxHandler() = delete;
+
+    /**
+     * @brief Creates a handler building matrices with the given factory.
+     * @param factory Factory used to create the loaded matrices.
+     * @param allow_shards Whether names may refer to shard files.
+     * @param selected Names of the matrices to load, others are skipped
+     *                 without being built. Empty to load all of them.
+     */
+    explicit MatrixSaxHandler(MatrixFactory factory,
+                              bool allow_shards = false,
+                              std::unordered_set<std::string> selected = {});
+
+    bool null() override;
+
+    bool boolean(bool val) override;
+
+    bool number_integer(number_integer_t val) override;
+
+    bool number_unsigned(number_unsigned_t val) override;
+
+    bool number_float(number_float_t val, const string_t & s) override;
+
+    bool string(string_t & val) override;
+
+    bool binary(binary_t & val) override;
+
+    bool start_object(std::size_t elements) override;
+
+    bool key(string_t & val) override;
+
+    bool end_object() override;
+
+    bool start_array(std::size_t elements) override;
+
+    bool end_array() override;
+
+    bool parse_error(std::size_t position, const std::string & last_token,
+                     const nlohmann::detail::exception & ex) override;
+
+    /**
+     * @brief Getter for the description of the error, which stopped the
+     *        parsing.
+     * @return Description of the error, empty if there was none.
+     */
+    const std::string & error() const;
+
+    /**
+     * @brief Getter for the loaded matrices.
+     * @return Matrices mapped by their names.
+     */
+    std::unordered_map<std::string, Matrix> & matrices();
+
+    /**
+     * @brief Getter for the shards listed in a manifest.
+     * @return Pairs of names and filenames of the shards, in the order of
+     *         the manifest.
+     */
+    const std::vector<std::pair<std::string, std::string>> & shards() const;
+
+  private:
+    /**
+     * @brief Position of a value in the expected format, determined by the
+     *        enclosing containers and keys.
+     */
+    enum class Slot {
+        TOP,
+        MATRIX,
+        ROWS,
+        COLUMNS,
+        DATA,
+        IGNORED,
+        ARRAY,
+        ELEMENT,
+        ROW,
+        VALUE,
+        NESTED
+    };
+
+    /**
+     * @brief Everything read about the matrix being parsed.
+     */
+    struct PendingMatrix {
+        std::optional<double> rows; // value of "rows" if it was a number
+        std::optional<double> columns; // value of "columns" if it was a number
+        bool has_data = false; // "data" was present
+        bool data_is_null = false; // "data" was null
+        bool has_array = false; // "data" contained "array"
+        bool check_failed = false; // a value of an unexpected type was read
+        bool element_check_failed = false; // a sparse value wasn't a number
+        std::string read_error; // first error in the dense array
+        std::string element_error; // first invalid key of sparse data
+        DenseMatrix::Buffer data; // dense rows laid out for adoption
+        std::size_t array_rows = 0; // number of finished dense rows
+        std::size_t array_columns = 0; // expected length of dense rows
+        std::size_t row_length = 0; // length of the current dense row
+        std::vector<MatrixElement> elements; // non-zeroes of sparse data
+    };
+
+    /**
+     * @brief Factory used to create the loaded matrices.
+     */
+    MatrixFactory _factory;
+
+    /**
+     * @brief Matrices loaded so far, mapped by their names.
+     */
+    std::unordered_map<std::string, Matrix> _matrices;
+
+    /**
+     * @brief Description of the error, which stopped the parsing.
+     */
+    std::string _error;
+
+    /**
+     * @brief Whether names may refer to shard files.
+     */
+    bool _allow_shards;
+
+    /**
+     * @brief Names of the matrices to load, empty to load all of them.
+     */
+    std::unordered_set<std::string> _selected;
+
+    /**
+     * @brief Names and filenames of the shards read so far.
+     */
+    std::vector<std::pair<std::string, std::string>> _shards;
+
+    /**
+     * @brief Number of currently open containers.
+     */
+    std::size_t _depth = 0;
+
+    /**
+     * @brief Depth of an ignored container, whose contents are skipped, or
+     *        zero if nothing is skipped.
+     */
+    std::size_t _skip_depth = 0;
+
+    /**
+     * @brief Name of the matrix being parsed.
+     */
+    std::string _name;
+
+    /**
+     * @brief Last key read in the object of the current matrix.
+     */
+    std::string _key;
+
+    /**
+     * @brief Last key read in the data of the current matrix.
+     */
+    std::string _data_key;
+
+    /**
+     * @brief Contents of the matrix being parsed.
+     */
+    PendingMatrix _pending;
+
+    /**
+     * @brief Determines the position of the next value from the current
+     *        depth and keys.
+     */
+    Slot slot() const;
+
+    /**
+     * @brief Handles a value, which isn't a container.
+     * @param number The value if it's a number, an empty optional otherwise.
+     * @param is_null Whether the value is null.
+     * @return Whether parsing should proceed.
+     */
+    bool scalar(std::optional<double> number, bool is_null);
+
+    /**
+     * @brief Creates the parsed matrix once its object ends.
+     * @return Whether parsing should proceed.
+     */
+    bool finish_matrix();
+
+    /**
+     * @brief Stores a read error of the current matrix, only the first
+     *        one is kept. Data of the matrix isn't stored from now on.
+     */
+    void fail_read(const std::string & message);
+
+    /**
+     * @brief Decides, whether the matrix called <b>_name</b> is loaded.
+     */
+    bool is_selected() const;
+};
@@ -1,9 +1,14 @@
 #include "Evaluator.h"
 #include "../../exceptions/QuitSignal.h"
 #include "../../matrix_operations/OperationFactory.h"
+#include "../../matrix_wrapper/LinearCombination.h"
 #include "ContainerOperations.h"
 #include "ParsedInput.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -11,6 +16,37 @@
 
 static inline constexpr char RESULT_NAME[] = "RESULT";
 
+using Clock = std::chrono::steady_clock;
+
+// adds the time and the work done during its lifetime to the statistics of
+// an operation
+class OperationScope {
+  public:
+    explicit OperationScope(OperationStats & stats)
+        : _stats(stats), _counters(profile_counters()), _start(Clock::now()) {}
+
+    OperationScope(const OperationScope &) = delete;
+
+    ~OperationScope() {
+        auto counters = profile_counters() - _counters;
+        ++_stats.calls;
+        _stats.time += Clock::now() - _start;
+        _stats.conversions += counters.conversions;
+        _stats.allocated_bytes += counters.allocated_bytes;
+    }
+
+    void touch(const Matrix & matrix) { _stats.elements += matrix.nnz(); }
+
+  private:
+    OperationStats & _stats;
+    ProfileCounters _counters;
+    Clock::time_point _start;
+};
+
+static double milliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
 static std::vector<Matrix> get_args(std::stack<std::string> & token_stack,
                                     const ContainerOperations & actions,
                                     std::size_t n) {
@@ -28,16 +64,58 @@ void Evaluator::load_nontmp_vars(const Evaluator::VariableMap & tmps) {
         if (!string_has_prefix(key, RESERVED_NAME_PREFIX)) {
             if (_vars.count(key)) {
                 _stream << "Warning: Redefinition of variable: " << key
-                        << std::endl;
+                        << '\n';
                 _vars.erase(key);
             }
             _vars.emplace(key, val);
+            mark_changed(key);
+        }
+    }
+}
+
+void Evaluator::mark_changed(const std::string & name) {
+    _versions[name] = ++_last_version;
+}
+
+std::unordered_set<std::string>
+Evaluator::update_targets(const std::string & filename,
+                          const std::vector<std::string> & names) const {
+    std::unordered_set<std::string> result(names.begin(), names.end());
+    auto stored = _stored_versions.find(filename);
+    if (stored == _stored_versions.end()) {
+        // nothing is known about the file, it gets the whole workspace
+        if (names.empty()) {
+            for (const auto & [name, val] : _vars) {
+                result.insert(name);
+            }
+        }
+        return result;
+    }
+    for (const auto & [name, version] : stored->second) {
+        if (_vars.count(name)) {
+            result.insert(name);
+        }
+    }
+    return result;
+}
+
+std::unordered_set<std::string>
+Evaluator::dirty_vars(const std::string & filename,
+                      const std::unordered_set<std::string> & names) const {
+    std::unordered_set<std::string> result;
+    auto stored = _stored_versions.find(filename);
+    for (const auto & name : names) {
+        if (stored == _stored_versions.end() ||
+            !stored->second.count(name) ||
+            stored->second.at(name) != _versions.at(name)) {
+            result.insert(name);
         }
     }
+    return result;
 }
 
 void Evaluator::print_available_vars() const {
-    _stream << "Available variables: " << std::endl;
+    _stream << "Available variables: \n";
     std::size_t cnt = 0;
     for (const auto & [key, val] : _vars){
         _stream << key;
@@ -46,22 +124,102 @@ void Evaluator::print_available_vars() const {
             _stream << ",";
         }
     }
-    _stream << std::endl;
+    _stream << '\n';
 }
 
-enum class SpecialCases { PRINT, EXPORT, IMPORT, ASSIGN };
+void Evaluator::print_matrix(const Matrix & matrix) {
+    auto start = Clock::now();
+    _stream << matrix << '\n';
+    _print_time += Clock::now() - start;
+}
+
+void Evaluator::print_stats() const {
+    std::ostringstream table;
+    table << std::left << std::setw(12) << "Operation" << std::right
+          << std::setw(10) << "Calls" << std::setw(14) << "Time [ms]"
+          << std::setw(14) << "Elements" << std::setw(13) << "Conversions"
+          << std::setw(16) << "Allocated [B]";
+    table << std::fixed << std::setprecision(3);
+    for (const auto & [name, stats] : _stats) {
+        table << '\n'
+              << std::left << std::setw(12) << name << std::right
+              << std::setw(10) << stats.calls << std::setw(14)
+              << milliseconds(stats.time) << std::setw(14) << stats.elements
+              << std::setw(13) << stats.conversions << std::setw(16)
+              << stats.allocated_bytes;
+    }
+    table << "\nSparse node arenas: " << profile_counters().arena_chunks
+          << " chunks allocated, " << arena_bytes_in_use()
+          << " bytes in use";
+    _stream << table.str() << '\n';
+}
+
+void Evaluator::print_times(const ParsedInput & input,
+                            std::chrono::nanoseconds total,
+                            const ProfileCounters & counters,
+                            std::chrono::nanoseconds print_time) const {
+    // conversions on worker threads may overlap with the evaluation
+    auto evaluation = std::max(
+        total - counters.conversion_time - print_time,
+        std::chrono::nanoseconds(0));
+    std::ostringstream times;
+    times << std::fixed << std::setprecision(3) << "Time: parse "
+          << milliseconds(input.parse_time) << " ms, evaluate "
+          << milliseconds(evaluation) << " ms, convert "
+          << milliseconds(counters.conversion_time) << " ms, print "
+          << milliseconds(print_time) << " ms";
+    _stream << times.str() << '\n';
+}
+
+enum class SpecialCases { PRINT, EXPORT, IMPORT, UPDATE, ASSIGN };
+
+enum class LinearOperations { PLUS, MINUS, MUL };
+
+// operations, whose results are kept as unevaluated linear combinations
+inline const std::unordered_map<std::string, LinearOperations>
+    linear_operation_table = {{"+", LinearOperations::PLUS},
+                              {"-", LinearOperations::MINUS},
+                              {"*", LinearOperations::MUL}};
 
 inline const std::unordered_map<std::string, SpecialCases> special_case_table =
     {{"PRINT", SpecialCases::PRINT},
      {"EXPORT", SpecialCases::EXPORT},
      {"IMPORT", SpecialCases::IMPORT},
+     {"UPDATE", SpecialCases::UPDATE},
      {"=", SpecialCases::ASSIGN}};
 
-Evaluator::Evaluator(MatrixFactory factory, std::ostream & os)
-    : InputHandler(factory), _stream(os), _exporter(factory),
+// pops the arguments of EXPORT, IMPORT and UPDATE, the first one is the name
+// of the file, the rest are names of variables
+static std::vector<std::string>
+take_file_arguments(std::stack<std::string> & process_stack) {
+    std::vector<std::string> names;
+    while (!process_stack.empty()) {
+        names.push_back(process_stack.top());
+        process_stack.pop();
+    }
+    std::reverse(names.begin(), names.end());
+    return names;
+}
+
+Evaluator::Evaluator(MatrixFactory factory, std::ostream & os,
+                     ExportOptions export_options)
+    : InputHandler(factory), _stream(os), _exporter(factory, export_options),
       _importer(factory) {}
 
 void Evaluator::evaluate_input(const ParsedInput & input) {
+    if (!input.timed) {
+        evaluate(input);
+        return;
+    }
+    auto counters = profile_counters();
+    auto print_time = _print_time;
+    auto start = Clock::now();
+    evaluate(input);
+    print_times(input, Clock::now() - start, profile_counters() - counters,
+                _print_time - print_time);
+}
+
+void Evaluator::evaluate(const ParsedInput & input) {
     auto & output_queue = *input.output_queue;
     auto & temp_vars = *input.loaded_variables;
     load_nontmp_vars(temp_vars);
@@ -69,7 +227,15 @@ void Evaluator::evaluate_input(const ParsedInput & input) {
     OperationFactory op_factory;
     bool an_operator_occurred = false;
 
+    // results of +, - and scalar * are evaluated only once they are used
+    // by another operation, so chains of them are fused into a single pass
+    std::unordered_map<std::string, LinearCombination> combinations;
+
     auto getter = [&](const std::string & key) -> Matrix & {
+        if (combinations.count(key)) {
+            temp_vars.insert_or_assign(key, combinations.at(key).evaluate());
+            combinations.erase(key);
+        }
         if (_vars.count(key)) {
             return _vars.at(key);
         } else if (temp_vars.count(key)) {
@@ -80,6 +246,23 @@ void Evaluator::evaluate_input(const ParsedInput & input) {
 
     ContainerOperations actions(std::move(getter));
 
+    // operands, which aren't combinations, are counted as touched by the
+    // operation, combinations are evaluated and counted by the operation
+    // using them
+    auto take_combination = [&](OperationScope & scope) {
+        std::string token = process_stack.top();
+        process_stack.pop();
+        auto combination = combinations.find(token);
+        if (combination == combinations.end()) {
+            const Matrix & matrix = actions.get_var(token);
+            scope.touch(matrix);
+            return LinearCombination(matrix);
+        }
+        LinearCombination result = std::move(combination->second);
+        combinations.erase(combination);
+        return result;
+    };
+
     while (!output_queue.empty()) {
         std::string token = output_queue.front();
         output_queue.pop();
@@ -91,40 +274,111 @@ void Evaluator::evaluate_input(const ParsedInput & input) {
             throw QuitSignal();
         }
 
+        if (token == "STATS") {
+            if (!output_queue.empty() || !process_stack.empty()) {
+                throw std::runtime_error("Invalid use of STATS.");
+            }
+            print_stats();
+            return;
+        }
+
         if (special_case_table.count(token)) {
             an_operator_occurred = true;
+            OperationScope scope(_stats[token]);
             switch (special_case_table.at(token)) {
             case SpecialCases::PRINT: {
                 if (process_stack.size() != 1) {
                     throw std::runtime_error("Invalid use of PRINT.");
                 }
                 auto arg = get_args(process_stack, actions, 1);
-                _stream << arg[0] << std::endl;
+                scope.touch(arg[0]);
+                print_matrix(arg[0]);
                 continue;
             }
             case SpecialCases::EXPORT: {
-                if (process_stack.size() != 1) {
+                if (process_stack.empty()) {
                     throw std::runtime_error("Invalid use of EXPORT.");
                 }
-                const std::string & filename = process_stack.top();
-                _exporter.export_to_file(_vars, filename);
-                _stream << _exporter.status() << std::endl;
-                process_stack.pop();
+                auto names = take_file_arguments(process_stack);
+                std::string filename = names.front();
+                names.erase(names.begin());
+                if (names.empty()) {
+                    _exporter.export_to_file(_vars, filename);
+                    if (_exporter.good()) {
+                        _stored_versions.erase(filename);
+                        for (const auto & [name, val] : _vars) {
+                            names.push_back(name);
+                            scope.touch(val);
+                        }
+                        mark_stored(filename, names);
+                    }
+                } else {
+                    VariableMap selected;
+                    for (const auto & name : names) {
+                        if (!_vars.count(name)) {
+                            throw std::runtime_error("Unknown variable: " +
+                                                     name);
+                        }
+                        selected.insert_or_assign(name, _vars.at(name));
+                        scope.touch(_vars.at(name));
+                    }
+                    _exporter.export_to_file(selected, filename);
+                    if (_exporter.good()) {
+                        _stored_versions.erase(filename);
+                        mark_stored(filename, names);
+                    }
+                }
+                _stream << _exporter.status() << '\n';
                 return;
             }
             case SpecialCases::IMPORT: {
-                if (process_stack.size() != 1) {
+                if (process_stack.empty()) {
                     throw std::runtime_error("Invalid use of IMPORT.");
                 }
-                const std::string & filename = process_stack.top();
-                _importer.import_from_file(_vars, filename);
-                _stream << _importer.status() << std::endl;
-                process_stack.pop();
+                auto names = take_file_arguments(process_stack);
+                std::string filename = names.front();
+                names.erase(names.begin());
+                _importer.import_from_file(_vars, filename, names);
+                _stream << _importer.status() << '\n';
                 if (_importer.good()) {
+                    // imported variables match the file they came from
+                    for (const auto & name : _importer.imported()) {
+                        mark_changed(name);
+                        scope.touch(_vars.at(name));
+                    }
+                    mark_stored(filename, _importer.imported());
                     print_available_vars();
                 }
                 return;
             }
+            case SpecialCases::UPDATE: {
+                if (process_stack.empty()) {
+                    throw std::runtime_error("Invalid use of UPDATE.");
+                }
+                auto names = take_file_arguments(process_stack);
+                std::string filename = names.front();
+                names.erase(names.begin());
+                for (const auto & name : names) {
+                    if (!_vars.count(name)) {
+                        throw std::runtime_error("Unknown variable: " + name);
+                    }
+                }
+                auto targets = update_targets(filename, names);
+                VariableMap selected;
+                for (const auto & name : targets) {
+                    selected.insert_or_assign(name, _vars.at(name));
+                }
+                auto dirty = dirty_vars(filename, targets);
+                _exporter.update_file(selected, dirty, filename);
+                _stream << _exporter.status() << '\n';
+                if (_exporter.good()) {
+                    mark_stored(filename, targets);
+                    for (const auto & name : dirty) {
+                        scope.touch(_vars.at(name));
+                    }
+                }
+                return;
+            }
             case SpecialCases::ASSIGN: {
                 if (process_stack.size() < 2) {
                     throw std::runtime_error(
@@ -138,10 +392,11 @@ void Evaluator::evaluate_input(const ParsedInput & input) {
                 }
                 if (_vars.count(dest)) {
                     _stream << "Warning: Redefinition of variable: " << dest
-                            << std::endl;
+                            << '\n';
                 }
                 _vars.erase(dest);
                 _vars.emplace(dest, std::move(arg[0]));
+                mark_changed(dest);
                 if (process_stack.size() == 1) {
                     process_stack.pop();
                 }
@@ -159,20 +414,59 @@ void Evaluator::evaluate_input(const ParsedInput & input) {
         std::shared_ptr<MatrixOp> operation(op_factory.get_operation(token));
         if (process_stack.size() < operation->arity()) {
             _stream << "Not enough arguments for operation: " << token
-                    << std::endl;
+                    << '\n';
             return;
         }
-        Matrix result = operation->evaluate(
-            get_args(process_stack, actions, operation->arity()));
+        OperationScope scope(_stats[operation->name()]);
         std::string temporary_name = get_temporary_name(RESULT_NAME);
+        if (linear_operation_table.count(token)) {
+            LinearCombination rhs = take_combination(scope);
+            LinearCombination lhs = take_combination(scope);
+            switch (linear_operation_table.at(token)) {
+            case LinearOperations::PLUS:
+                lhs += rhs;
+                break;
+            case LinearOperations::MINUS:
+                lhs -= rhs;
+                break;
+            case LinearOperations::MUL:
+                if (lhs.is_scalar()) {
+                    rhs *= lhs.scalar_value();
+                    std::swap(lhs, rhs);
+                } else if (rhs.is_scalar()) {
+                    lhs *= rhs.scalar_value();
+                } else {
+                    Matrix result =
+                        operation->evaluate({rhs.evaluate(), lhs.evaluate()});
+                    scope.touch(result);
+                    temp_vars.emplace(temporary_name, std::move(result));
+                    process_stack.push(temporary_name);
+                    continue;
+                }
+                break;
+            }
+            combinations.emplace(temporary_name, std::move(lhs));
+            process_stack.push(temporary_name);
+            continue;
+        }
+        auto args = get_args(process_stack, actions, operation->arity());
+        for (const auto & arg : args) {
+            scope.touch(arg);
+        }
+        Matrix result = operation->evaluate(args);
+        scope.touch(result);
         temp_vars.emplace(temporary_name, std::move(result));
         process_stack.push(temporary_name);
     }
     if (!process_stack.empty()) {
         if (process_stack.size() == 1) {
+            // printing the leftover is an implicit PRINT, which evaluates
+            // a remaining combination
+            OperationScope scope(_stats["PRINT"]);
             std::string leftover = process_stack.top();
             Matrix res = actions.get_var(leftover);
-            _stream << res << std::endl;
+            scope.touch(res);
+            print_matrix(res);
         } else if (!an_operator_occurred) {
             throw std::runtime_error("No operator has been found.");
         } else {
@@ -4,14 +4,49 @@
 #include "../../matrix_wrapper/MatrixFactory.h"
 #include "../file_handling/Exporter.h"
 #include "../file_handling/Importer.h"
+#include "../../profiling/ProfileCounters.h"
 #include "ContainerOperations.h"
 #include "InputHandler.h"
 #include "ParsedInput.h"
+#include <chrono>
+#include <map>
 #include <memory>
 #include <queue>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Cumulative statistics of a single operation, printed by "STATS".
+ */
+struct OperationStats {
+    /**
+     * @brief Number of evaluations of the operation.
+     */
+    std::size_t calls = 0;
+
+    /**
+     * @brief Total time of the evaluations.
+     */
+    std::chrono::nanoseconds time{0};
+
+    /**
+     * @brief Non-zero elements of the arguments and results.
+     */
+    std::size_t elements = 0;
+
+    /**
+     * @brief Conversions of representations during the evaluations.
+     */
+    std::size_t conversions = 0;
+
+    /**
+     * @brief Storage allocated by representations during the evaluations.
+     */
+    std::size_t allocated_bytes = 0;
+};
 
 /**
  * @brief A class for evaluating user input parsed in Reverse Polish Notation.
@@ -25,11 +60,14 @@ class Evaluator : public InputHandler {
      * @param factory Factory used for creating temporary matrices as a result
      *                of sub-expressions.
      * @param output A stream into which the result will be printed.
+     * @param export_options Options of exports to JSON files.
      */
-    Evaluator(MatrixFactory factory, std::ostream & output);
+    Evaluator(MatrixFactory factory, std::ostream & output,
+              ExportOptions export_options = {});
 
     /**
-     * @brief Evaluates the provided user input.
+     * @brief Evaluates the provided user input. If the input was prefixed
+     *        with "TIME", the time of its phases is printed afterwards.
      * @param input Input parsed to Reverse Polish Notation. See
      *              <b>ParsedInput</b> struct for more information.
      * @throws std::runtime_error if a parsed token cannot be recognized -
@@ -47,13 +85,24 @@ class Evaluator : public InputHandler {
      *                               attempted.
      * @throws std::runtime_error if assignment is called with less than two
      *                            arguments.
-     * @throws std::runtime_error if "QUIT" is used in a compound expression.
+     * @throws std::runtime_error if "QUIT" or "STATS" is used in a compound
+     *                            expression.
      * @throws QuitSignal if "QUIT" is read from user input.
      */
     void evaluate_input(const ParsedInput & input);
 
   private:
 
+    /**
+     * @brief Statistics of the evaluated operations, mapped by their names.
+     */
+    std::map<std::string, OperationStats> _stats;
+
+    /**
+     * @brief Total time spent printing matrices.
+     */
+    std::chrono::nanoseconds _print_time{0};
+
     /**
      * @brief Stream into which the results will be printed.
      */
@@ -64,6 +113,25 @@ class Evaluator : public InputHandler {
      */
     VariableMap _vars;
 
+    /**
+     * @brief Version of every variable, increased whenever it changes.
+     */
+    std::unordered_map<std::string, std::size_t> _versions;
+
+    /**
+     * @brief Last version given to a variable.
+     */
+    std::size_t _last_version = 0;
+
+    /**
+     * @brief Versions of the variables stored in every file written or read
+     *        so far, mapped by the names of the files. Variables with a
+     *        different version are dirty and written by "UPDATE".
+     */
+    std::unordered_map<std::string,
+                       std::unordered_map<std::string, std::size_t>>
+        _stored_versions;
+
     /**
      * @brief An exporter used for writing variables to files when an "EXPORT"
      *        token is detected.
@@ -82,8 +150,82 @@ class Evaluator : public InputHandler {
      */
     void load_nontmp_vars(const VariableMap & temp_vars);
 
+    /**
+     * @brief Evaluates the provided user input, see <b>evaluate_input</b>.
+     * @param input Input parsed to Reverse Polish Notation.
+     */
+    void evaluate(const ParsedInput & input);
+
     /**
      * @brief Prints newly available variables after importing from a file.
      */
     void print_available_vars() const;
+
+    /**
+     * @brief Prints a matrix to the output stream, adding to
+     *        <b>_print_time</b>.
+     * @param matrix Matrix to print.
+     */
+    void print_matrix(const Matrix & matrix);
+
+    /**
+     * @brief Prints the statistics of all operations evaluated so far.
+     */
+    void print_stats() const;
+
+    /**
+     * @brief Prints the time of the phases of a timed input.
+     * @param input The evaluated input.
+     * @param total Time of the evaluation, including conversions and
+     *              printing.
+     * @param counters Work done during the evaluation.
+     * @param print_time Time spent printing during the evaluation.
+     */
+    void print_times(const ParsedInput & input, std::chrono::nanoseconds total,
+                     const ProfileCounters & counters,
+                     std::chrono::nanoseconds print_time) const;
+
+    /**
+     * @brief Gives a new version to a variable, which was changed.
+     * @param name Name of the variable.
+     */
+    void mark_changed(const std::string & name);
+
+    /**
+     * @brief Records that the current versions of the given variables are
+     *        stored in a file.
+     * @param filename Name of the file.
+     * @param names Names of the variables stored in the file.
+     */
+    template <typename Names>
+    void mark_stored(const std::string & filename, const Names & names) {
+        auto & stored = _stored_versions[filename];
+        for (const auto & name : names) {
+            stored[name] = _versions[name];
+        }
+    }
+
+    /**
+     * @brief Collects the variables, which "UPDATE" keeps in a file: the
+     *        ones written to or read from the file before and the listed
+     *        ones. All variables, if nothing is known about the file and no
+     *        variables are listed.
+     * @param filename Name of the file.
+     * @param names Names of the variables listed by the user.
+     * @return Names of the variables kept in the file.
+     */
+    std::unordered_set<std::string>
+    update_targets(const std::string & filename,
+                   const std::vector<std::string> & names) const;
+
+    /**
+     * @brief Selects the variables, which changed since they were last
+     *        written to or read from a file.
+     * @param filename Name of the file.
+     * @param names Names of the variables to select from.
+     * @return Names of the dirty variables.
+     */
+    std::unordered_set<std::string>
+    dirty_vars(const std::string & filename,
+               const std::unordered_set<std::string> & names) const;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../matrix_wrapper/Matrix.h"
+#include <chrono>
 #include <memory>
 #include <queue>
 #include <string>
@@ -33,4 +34,15 @@ class ParsedInput {
      *        as some anonymous values may be used in user input.
      */
     VariableMapPointer loaded_variables;
+
+    /**
+     * @brief True if the input was prefixed with "TIME" and the time of
+     *        its phases should be reported.
+     */
+    bool timed = false;
+
+    /**
+     * @brief Time spent parsing the input, excluding waiting for it.
+     */
+    std::chrono::nanoseconds parse_time{0};
 };
@@ -1,15 +1,20 @@
 #include "Parser.h"
-#include "../../iterators/DenseMatrixIterator.h"
+#include "../../representations/DenseMatrix.h"
 #include "../../matrix_operations/OperationFactory.h"
 #include "InputHandler.h"
 #include "ParsedInput.h"
-#include <ios>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
 #include <optional>
-#include <sstream>
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 inline constexpr char TMP_NAME[] = "TMP";
@@ -18,19 +23,170 @@ Parser::Parser(MatrixFactory factory, std::istream & stream,
                std::size_t max_input_len)
     : InputHandler(factory), _stream(stream), _max_len(max_input_len) {}
 
-static std::optional<double> read_double(const std::string & token) {
-    std::size_t len = 0;
+std::size_t Parser::lines_read() const {
+    return _lines_read;
+}
+
+// whitespace as skipped by std::ws in the classic locale
+static bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static void skip_spaces(std::string_view & input) {
+    std::size_t length = 0;
+    while (length < input.size() && is_space(input[length])) {
+        ++length;
+    }
+    input.remove_prefix(length);
+}
+
+// splits off the next whitespace separated token, empty at the end of input
+static std::string_view next_token(std::string_view & input) {
+    skip_spaces(input);
+    std::size_t length = 0;
+    while (length < input.size() && !is_space(input[length])) {
+        ++length;
+    }
+    std::string_view token = input.substr(0, length);
+    input.remove_prefix(length);
+    return token;
+}
+
+// converts a whole token to a number in the formats accepted by std::stod,
+// returns nothing if the token doesn't start with a number
+static std::optional<double> read_double(std::string_view token) {
+    const char * first = token.data();
+    const char * last = first + token.size();
+    bool negative = first != last && *first == '-';
+    if (first != last && (*first == '+' || *first == '-')) {
+        ++first;
+    }
+    if (first == last || *first == '+' || *first == '-') {
+        return std::nullopt;
+    }
     double val = 0;
-    try {
-        val = std::stod(token, &len);
-    } catch (std::exception & e) {
+    std::from_chars_result result{first, std::errc::invalid_argument};
+    if (last - first > 2 && first[0] == '0' &&
+        (first[1] == 'x' || first[1] == 'X') && first[2] != '+' &&
+        first[2] != '-') {
+        result = std::from_chars(first + 2, last, val, std::chars_format::hex);
+        if (result.ec == std::errc::invalid_argument) {
+            // only the leading zero is a number
+            result = {first + 1, std::errc()};
+        }
+    } else {
+        result = std::from_chars(first, last, val);
+    }
+    if (result.ec != std::errc()) {
         return std::nullopt;
     }
-    if (len != token.length()) {
+    if (result.ptr != last) {
         throw std::invalid_argument("Identifiers cannot begin with a number.");
     }
+    return negative ? -val : val;
+}
+
+// powers of ten which are exactly representable as doubles
+static constexpr double EXACT_POWERS[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// reads a decimal number whose digits and power of ten are both exact
+// doubles, a single multiplication or division then rounds it correctly;
+// returns nullptr for all other numbers
+static const char * read_exact(const char * first, const char * last,
+                               double & val) {
+    const char * it = first;
+    bool negative = it != last && *it == '-';
+    if (negative) {
+        ++it;
+    }
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    for (; it != last && is_digit(*it); ++it, ++digits) {
+        mantissa = mantissa * 10 + (*it - '0');
+    }
+    if (it != last && *it == '.') {
+        for (++it; it != last && is_digit(*it); ++it, ++digits, --exponent) {
+            mantissa = mantissa * 10 + (*it - '0');
+        }
+    }
+    // more digits could overflow the mantissa
+    if (!digits || digits > 19) {
+        return nullptr;
+    }
+    if (it != last && (*it == 'e' || *it == 'E')) {
+        const char * exponent_it = it + 1;
+        bool exponent_negative = false;
+        if (exponent_it != last &&
+            (*exponent_it == '+' || *exponent_it == '-')) {
+            exponent_negative = *exponent_it == '-';
+            ++exponent_it;
+        }
+        int written = 0;
+        for (int length = 0; exponent_it != last && is_digit(*exponent_it);
+             ++exponent_it, ++length) {
+            if (length == 4) {
+                return nullptr;
+            }
+            written = written * 10 + (*exponent_it - '0');
+        }
+        // an exponent without digits isn't a part of the number
+        if (exponent_it != it + 1 && is_digit(exponent_it[-1])) {
+            exponent += exponent_negative ? -written : written;
+            it = exponent_it;
+        }
+    }
+    constexpr int max_exponent = sizeof(EXACT_POWERS) / sizeof(double) - 1;
+    if (mantissa > (std::uint64_t(1) << 53) || exponent < -max_exponent ||
+        exponent > max_exponent) {
+        return nullptr;
+    }
+    val = static_cast<double>(mantissa);
+    val = exponent < 0 ? val / EXACT_POWERS[-exponent]
+                       : val * EXACT_POWERS[exponent];
+    if (negative) {
+        val = -val;
+    }
+    return it;
+}
+
+// reads a number from the start of the input in the format accepted by
+// streams: an optional sign followed by decimal digits
+static std::optional<double> read_number(std::string_view & input) {
+    const char * first = input.data();
+    const char * last = first + input.size();
+    bool plus = first != last && *first == '+';
+    if (plus) {
+        ++first;
+    }
+    const char * digits = first;
+    if (!plus && digits != last && *digits == '-') {
+        ++digits;
+    }
+    if (digits == last || !(is_digit(*digits) || *digits == '.')) {
+        return std::nullopt;
+    }
+    double val = 0;
+    const char * end = read_exact(first, last, val);
+    if (!end) {
+        auto [ptr, error] = std::from_chars(first, last, val);
+        if (error == std::errc::result_out_of_range) {
+            // streams round underflows towards zero and reject overflows
+            val = std::strtod(std::string(first, ptr).c_str(), nullptr);
+            if (std::isinf(val)) {
+                return std::nullopt;
+            }
+        } else if (error != std::errc()) {
+            return std::nullopt;
+        }
+        end = ptr;
+    }
+    input.remove_prefix(end - input.data());
     return val;
 }
+
 // implements Dijkstra's Shunting-yard algorithm
 //  https://en.wikipedia.org/wiki/Shunting_yard_algorithm
 ParsedInput Parser::parse_input() const {
@@ -43,7 +199,8 @@ ParsedInput Parser::parse_input() const {
 
     std::unique_ptr<char[]> buffer(new char[_max_len + 1]);
     _stream.getline(buffer.get(), _max_len);
-    if (_stream.eof()) {
+    // the last line of a file may lack the line break
+    if (_stream.eof() && !_stream.gcount()) {
         throw std::invalid_argument("End-of-file reached.");
     }
     if (_stream.bad()) {
@@ -52,22 +209,35 @@ ParsedInput Parser::parse_input() const {
     if (_stream.fail()) {
         throw std::length_error("Maximum input length exceeded.");
     }
+    ++_lines_read;
 
-    std::stringstream line_stream(buffer.get());
-    while (line_stream >> std::ws && !line_stream.eof()) {
-        std::string token;
-
+    auto start = std::chrono::steady_clock::now();
+    std::string_view line(buffer.get());
+    // a leading TIME only asks for the phases of the rest to be timed
+    std::string_view rest = line;
+    if (next_token(rest) == "TIME") {
+        skip_spaces(rest);
+        if (rest.empty()) {
+            throw std::runtime_error("Invalid use of TIME.");
+        }
+        result.timed = true;
+        line = rest;
+    }
+    while (true) {
+        skip_spaces(line);
+        if (line.empty()) {
+            break;
+        }
         // inline matrix in input
-        if (line_stream.peek() == '[') {
-            char c;
-            line_stream >> c; // this is the peeked '['
+        if (line.front() == '[') {
+            line.remove_prefix(1);
             std::string new_name = get_temporary_name(TMP_NAME);
-            variables.emplace(new_name, load_matrix(line_stream));
+            variables.emplace(new_name, load_matrix(line));
             output_queue.push(new_name);
             continue;
         }
 
-        line_stream >> token;
+        std::string token(next_token(line));
         // check if token is reserved
         if (string_has_prefix(token, RESERVED_NAME_PREFIX)) {
             throw std::runtime_error("Token " + token + " is reserved.");
@@ -98,10 +268,8 @@ ParsedInput Parser::parse_input() const {
         }
         // token is a call of scan
         if (token == "SCAN") {
-            std::string name;
-            line_stream >> name;
-            if (line_stream.bad() || line_stream.fail() ||
-                string_has_prefix(name, RESERVED_NAME_PREFIX) ||
+            std::string name(next_token(line));
+            if (name.empty() || string_has_prefix(name, RESERVED_NAME_PREFIX) ||
                 operations.is_operation(name) || !output_queue.empty() ||
                 name == "SCAN") {
                 throw std::invalid_argument(
@@ -148,105 +316,122 @@ ParsedInput Parser::parse_input() const {
         operator_stack.pop();
     }
 
+    result.parse_time = std::chrono::steady_clock::now() - start;
     return result;
 }
 
-static bool read_row(std::istream & stream, std::vector<double> & row) {
-    char c = 0;
-    while (c != ']') {
-        double val;
-        stream >> std::ws;
-        stream >> val;
-        if (stream.fail()) {
-            return false;
-        }
-        row.emplace_back(val);
-        stream >> std::ws;
-        stream >> c;
+// appends the values of a row to the buffer, returns their number or
+// nothing if the row is malformed
+static std::optional<std::size_t> read_row(std::string_view & input,
+                                           DenseMatrix::Buffer & data) {
+    std::size_t row_begin = data.size();
+    while (true) {
+        skip_spaces(input);
+        auto val = read_number(input);
+        if (!val) {
+            return std::nullopt;
+        }
+        data.emplace_back(*val);
+        skip_spaces(input);
+        if (input.empty()) {
+            return std::nullopt;
+        }
+        char c = input.front();
+        input.remove_prefix(1);
         switch (c) {
         case ',':
             continue;
         case ']':
-            return true;
+            return data.size() - row_begin;
         default:
-            return false;
+            return std::nullopt;
         }
     }
-    return false;
 }
 
-static inline Matrix
-create_matrix_from_vec(const std::vector<std::vector<double>> & vec,
-                       const MatrixFactory factory) {
-    MatrixDimensions dims(vec.size(), vec.at(0).size());
-
-    return {{new DenseMatrixIterator(&dims, vec, 0, 0)},
-            {new DenseMatrixIterator(&dims, vec, dims.rows(), 0)},
-            factory};
+// pads the last row of the buffer to the stride of the matrix, checks that
+// it's as long as the previous ones
+static bool finish_row(DenseMatrix::Buffer & data, std::size_t length,
+                       std::size_t & columns) {
+    if (!columns) {
+        columns = length;
+    }
+    if (length != columns) {
+        return false;
+    }
+    data.resize(data.size() + DenseMatrix::stride_for(columns) - columns, 0);
+    return true;
 }
 
-Matrix Parser::load_matrix(std::istream & stream) const {
-    char c = 0;
-    std::vector<std::vector<double>> mx;
-    while (stream.peek() != ']' && !stream.eof()) {
-        std::vector<double> row;
-        stream >> c;
-        if (c != '[') {
+Matrix Parser::load_matrix(std::string_view & input) const {
+    DenseMatrix::Buffer data;
+    std::size_t rows = 0;
+    std::size_t columns = 0;
+    while (true) {
+        skip_spaces(input);
+        if (input.empty() || input.front() != '[') {
             throw std::runtime_error("Matrix parse error.");
         }
+        input.remove_prefix(1);
 
-        if (!read_row(stream, row)) {
+        auto length = read_row(input, data);
+        if (!length || !finish_row(data, *length, columns)) {
             throw std::runtime_error("Matrix parse error.");
         }
+        ++rows;
 
-        if (!mx.empty() && mx.back().size() != row.size()) {
+        skip_spaces(input);
+        if (input.empty()) {
             throw std::runtime_error("Matrix parse error.");
         }
-
-        stream >> c;
-        if (c == ',' || c == ']') {
-            mx.emplace_back(row);
-            if (c == ']') {
-                break;
-            }
-            continue;
+        char c = input.front();
+        input.remove_prefix(1);
+        if (c == ']') {
+            break;
+        }
+        if (c != ',') {
+            throw std::runtime_error("Matrix parse error.");
         }
-        throw std::runtime_error("Matrix parse error.");
-    }
-    if (c != ']') {
-        throw std::runtime_error("Matrix parse error.");
     }
-    return create_matrix_from_vec(mx, _factory);
+    return {rows, columns, std::move(data), _factory};
 }
 
 Matrix Parser::load_matrix_scan(std::istream & stream) const {
-    std::vector<std::vector<double>> mx;
+    DenseMatrix::Buffer data;
+    std::size_t rows = 0;
+    std::size_t columns = 0;
     std::string line;
 
-    while (std::getline(stream, line) && !line.empty()) {
-        std::vector<double> row;
-        std::istringstream line_stream(line);
-
-        line_stream >> std::ws;
-        char bracket;
-        line_stream >> bracket;
+    while (std::getline(stream, line)) {
+        ++_lines_read;
+        if (line.empty()) {
+            break;
+        }
+        std::string_view input(line);
 
-        if (bracket != '[') {
+        skip_spaces(input);
+        if (input.empty() || input.front() != '[') {
             throw std::runtime_error(
                 "Missing opening brace in scanned matrix.");
         }
+        input.remove_prefix(1);
 
-        if (!read_row(line_stream, row)) {
+        auto length = read_row(input, data);
+        if (!length) {
             throw std::runtime_error("Matrix scan error.");
         }
-        if (!(line_stream >> std::ws) || !(line_stream.eof())) {
+        skip_spaces(input);
+        if (!input.empty()) {
             throw std::runtime_error("Unexpected character in matrix scan.");
         }
-        if (!mx.empty() && mx.back().size() != row.size()) {
+        if (!finish_row(data, *length, columns)) {
             throw std::runtime_error("Row length mismatch in matrix.");
         }
-        mx.emplace_back(row);
+        ++rows;
+    }
+    if (!rows) {
+        throw std::runtime_error("Matrix scan error.");
     }
 
-    return create_matrix_from_vec(mx, _factory);
-}
\ No newline at end of file
+    return {rows, columns, std::move(data), _factory};
+}
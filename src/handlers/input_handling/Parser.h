@@ -6,6 +6,7 @@
 #include "ParsedInput.h"
 #include <cstdlib>
 #include <iostream>
+#include <string_view>
 
 /**
  * @brief A parsing unit used for parsing user input to Reverse Polish Notation.
@@ -36,6 +37,7 @@ class Parser : public InputHandler {
      *                            "SCAN" or if "SCAN" is used in a compound
      *                            expression.
      * @throws std::runtime_error if a matrix cannot be parsed in user input.
+     * @throws std::runtime_error if "TIME" isn't followed by an expression.
      * @throws std::invalid_argument if a token starts with a number.
      * @throws std::length_error if an expression exceeds the maximum allowed
      *                           limit.
@@ -47,20 +49,27 @@ class Parser : public InputHandler {
      */
     ParsedInput parse_input() const;
 
+    /**
+     * @brief Getter for the number of lines read from the input stream,
+     *        including the rows of scanned matrices.
+     * @return Number of lines read so far.
+     */
+    std::size_t lines_read() const;
+
   private:
 
     /**
      * @brief Parsers an inline matrix.
-     * @param stream Stream to load the matrix from.
+     * @param input Rest of the line following the opening brace of the
+     *              matrix, advanced past its closing brace.
      * @return Parsed inline matrix.
      * @throws std::runtime_error when a mismatch of braces is detected.
      * @throws std::runtime_error if all rows don't have the same number of
      *                            columns.
      * @throws std::runtime_error if the matrix contains other characters apart
      *                            from commas and braces.
-     * @throws std::runtime_error if <b>stream</b> fails.
      */
-    Matrix load_matrix(std::istream & stream) const;
+    Matrix load_matrix(std::string_view & input) const;
 
     /**
      * @brief Parsers a matrix in brace format.
@@ -84,4 +93,9 @@ class Parser : public InputHandler {
      * @brief Maximum length of each expression.
      */
     std::size_t _max_len;
+
+    /**
+     * @brief Number of lines read so far.
+     */
+    mutable std::size_t _lines_read = 0;
 };
@@ -0,0 +1,41 @@
+#include "CompressedSparseMatrixIterator.h"
+
+CompressedSparseMatrixIterator::CompressedSparseMatrixIterator(
+    const CompressedSparseMatrix * ptr, std::size_t index)
+    : AbstractMatrixIterator(&ptr->_dimensions, 0, 0), _matrix(ptr),
+      _index(index) {
+    update_position();
+}
+
+void CompressedSparseMatrixIterator::operator++() {
+    ++_index;
+    update_position();
+}
+
+MatrixElement CompressedSparseMatrixIterator::operator*() const {
+    return {_row, _column, _matrix->_values[_index]};
+}
+
+std::size_t CompressedSparseMatrixIterator::distance(
+    const AbstractMatrixIterator & other) const {
+    CompressedSparseMatrixIterator it_copy(*this);
+    std::size_t result = 0;
+    while (it_copy != other && it_copy._row < _ptr->rows()) {
+        ++it_copy;
+        ++result;
+    }
+    return result;
+}
+
+void CompressedSparseMatrixIterator::update_position() {
+    if (_index >= _matrix->_values.size()) {
+        _row = _ptr->rows();
+        _column = 0;
+        return;
+    }
+    const auto & offsets = _matrix->_row_offsets;
+    while (offsets[_row + 1] <= _index) {
+        ++_row;
+    }
+    _column = _matrix->_column_indices[_index];
+}
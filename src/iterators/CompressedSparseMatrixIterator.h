@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../representations/CompressedSparseMatrix.h"
+#include "AbstractMatrixIterator.h"
+
+/**
+ * @brief Implements iterators for the CompressedSparseMatrix matrix
+ *        representation.
+ */
+class CompressedSparseMatrixIterator : public AbstractMatrixIterator {
+  public:
+
+    /**
+     * @brief Initializes the iterator.
+     * @param ptr A pointer to the matrix into which the iterator will point.
+     * @param index Index of the current element into the value array of
+     *              the matrix. An index equal to the number of stored
+     *              elements represents the end of the matrix.
+     */
+    CompressedSparseMatrixIterator(const CompressedSparseMatrix * ptr,
+                                   std::size_t index);
+
+    /**
+     * @brief Moves the iterator to the next non-zero element of the matrix.
+     *        Behavior is undefined if the iterator is already pointing to the
+     *        end of the matrix.
+     */
+    void operator++() override;
+
+    /**
+     * @brief Allows access to the element the iterator is currently pointing to.
+     *        Behavior is undefined if the iterator is already pointing to the
+     *        end of the matrix.
+     * @return Position and value of the current element wrapped in a
+     *         <b>MatrixElement</b> struct.
+     */
+    MatrixElement operator*() const override;
+
+    /**
+     * @brief Calculates the number of non-zero element between <b>this</b> and
+     *        <b>dst</b>. Behavior is undefined if <b>dst</b> is unreachable
+     *        from <b>this</b>.
+     * @param dst An iterator to calculate the distance to.
+     * @return Distance to <b>dst</b>.
+     */
+    std::size_t distance(const AbstractMatrixIterator & dst) const override;
+
+  private:
+
+    /**
+     * @brief A pointer to the matrix the iterator is iterating over.
+     */
+    const CompressedSparseMatrix * _matrix;
+
+    /**
+     * @brief Index of the current element into the value array.
+     */
+    std::size_t _index;
+
+    /**
+     * @brief Updates the current row and column after <b>_index</b> changed.
+     */
+    void update_position();
+};
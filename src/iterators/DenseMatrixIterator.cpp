@@ -2,35 +2,30 @@
 
 DenseMatrixIterator::DenseMatrixIterator(const DenseMatrix * ptr,
                                          std::size_t row, std::size_t column)
-    : AbstractMatrixIterator(&ptr->_dimensions, row, column), _data(ptr->_data) {
-    while (_row < get_matrix_rows() && _data[_row][_column] == 0){
-        next_element();
-    }
+    : AbstractMatrixIterator(&ptr->_dimensions, row, column), _matrix(ptr),
+      _container(nullptr) {
+    skip_zeroes();
 }
 
 DenseMatrixIterator::DenseMatrixIterator(
     const MatrixDimensions * ptr, const DenseMatrixIterator::DenseMatrixContainer & vec,
-    std::size_t row, std::size_t column) : AbstractMatrixIterator(ptr, row, column), _data(vec) {
-    while ( _row < get_matrix_rows() && _data[_row][_column] == 0){
-        next_element();
-    }
+    std::size_t row, std::size_t column) : AbstractMatrixIterator(ptr, row, column), _matrix(nullptr), _container(&vec) {
+    skip_zeroes();
 }
 
 void DenseMatrixIterator::operator++() {
     next_element();
-    while (_row < get_matrix_rows() && _data[_row][_column] == 0) {
-        next_element();
-    }
+    skip_zeroes();
 }
 
 MatrixElement DenseMatrixIterator::operator*() const {
-    return {_row, _column, _data[_row][_column]};
+    return {_row, _column, value()};
 }
 
 std::size_t
 DenseMatrixIterator::distance(const AbstractMatrixIterator & other) const {
     DenseMatrixIterator it_copy(*this);
-    if (_row < get_matrix_rows() && _data[_row][_column] == 0){
+    if (_row < get_matrix_rows() && value() == 0){
         ++it_copy;
     }
     std::size_t result = 0;
@@ -41,6 +36,19 @@ DenseMatrixIterator::distance(const AbstractMatrixIterator & other) const {
     return result;
 }
 
+double DenseMatrixIterator::value() const {
+    if (_matrix) {
+        return _matrix->row(_row)[_column];
+    }
+    return (*_container)[_row][_column];
+}
+
+void DenseMatrixIterator::skip_zeroes() {
+    while (_row < get_matrix_rows() && value() == 0) {
+        next_element();
+    }
+}
+
 void DenseMatrixIterator::next_element() {
     ++_column;
     if (_column >= get_matrix_columns()) {
@@ -62,11 +62,31 @@ class DenseMatrixIterator : public AbstractMatrixIterator {
   private:
 
     /**
-     * @brief A const reference to the data container. A reference is used to
-     *        prevent needless copies, of course there is risk of keeping
-     *        a reference to dead data.
+     * @brief A pointer to the iterated matrix, if the iterator was created
+     *        from a <b>DenseMatrix</b>, nullptr otherwise. A pointer is used
+     *        to prevent needless copies, of course there is risk of keeping
+     *        a pointer to dead data.
      */
-    const DenseMatrixContainer & _data;
+    const DenseMatrix * _matrix;
+
+    /**
+     * @brief A pointer to the data container, if the iterator was created
+     *        from an external container, nullptr otherwise.
+     */
+    const DenseMatrixContainer * _container;
+
+    /**
+     * @brief Returns the value of the element at the current position.
+     *        Behavior is undefined if the iterator is past the last row.
+     * @return Value at the current position.
+     */
+    double value() const;
+
+    /**
+     * @brief Moves the iterator to the first non-zero element at or after
+     *        the current position.
+     */
+    void skip_zeroes();
 
     /**
      * @brief A helper function for iterating, moves the iterator to the next
@@ -2,13 +2,12 @@
 
 #include "../representations/SparseMatrix.h"
 #include "AbstractMatrixIterator.h"
-#include <map>
 
 /**
  * @brief Implements iterators for the SparseMatrix matrix representation.
  */
 class SparseMatrixIterator : public AbstractMatrixIterator {
-    using MapIterator = std::map<Position, double>::const_iterator;
+    using MapIterator = SparseMatrix::Map::const_iterator;
 
   public:
 
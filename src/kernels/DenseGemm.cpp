@@ -0,0 +1,138 @@
+#include "DenseGemm.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// the register tile computed by a single call of the micro-kernel
+static inline constexpr std::size_t MR = 4;
+static inline constexpr std::size_t NR = 8;
+
+// cache blocks: a packed lhs block (MC x KC) should fit into L2, a packed
+// rhs block (KC x NC) into L3 and a single rhs micro-panel (KC x NR) into L1
+static inline constexpr std::size_t MC = 96;
+static inline constexpr std::size_t KC = 256;
+static inline constexpr std::size_t NC = 2048;
+
+using PackBuffer = std::vector<double, AlignedAllocator<double>>;
+
+static inline std::size_t round_up(std::size_t value, std::size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// packs a block of lhs into micro-panels of MR rows, every micro-panel is
+// stored column by column, missing rows are padded with zeroes
+static void pack_lhs(const DenseMatrix & lhs, std::size_t row_begin,
+                     std::size_t rows, std::size_t depth_begin,
+                     std::size_t depth, double * dst) {
+    for (std::size_t i = 0; i < rows; i += MR) {
+        std::size_t panel_rows = std::min(MR, rows - i);
+        const double * src[MR] = {};
+        for (std::size_t r = 0; r < panel_rows; r++) {
+            src[r] = lhs.row(row_begin + i + r) + depth_begin;
+        }
+        for (std::size_t p = 0; p < depth; p++) {
+            for (std::size_t r = 0; r < MR; r++) {
+                *dst++ = r < panel_rows ? src[r][p] : 0;
+            }
+        }
+    }
+}
+
+// packs a block of rhs into micro-panels of NR columns, every micro-panel is
+// stored row by row, missing columns are padded with zeroes
+static void pack_rhs(const DenseMatrix & rhs, std::size_t depth_begin,
+                     std::size_t depth, std::size_t column_begin,
+                     std::size_t columns, double * dst) {
+    for (std::size_t j = 0; j < columns; j += NR) {
+        std::size_t panel_columns = std::min(NR, columns - j);
+        for (std::size_t p = 0; p < depth; p++) {
+            const double * src = rhs.row(depth_begin + p) + column_begin + j;
+            std::size_t c = 0;
+            for (; c < panel_columns; c++) {
+                *dst++ = src[c];
+            }
+            for (; c < NR; c++) {
+                *dst++ = 0;
+            }
+        }
+    }
+}
+
+// computes an MR x NR tile of the product in registers and adds its valid
+// part (rows x columns) to the result
+static void micro_kernel(std::size_t depth, const double * lhs_panel,
+                         const double * rhs_panel, double * const * result,
+                         std::size_t rows, std::size_t columns) {
+    double acc[MR][NR] = {};
+    for (std::size_t p = 0; p < depth; p++) {
+        for (std::size_t i = 0; i < MR; i++) {
+            double lhs_val = lhs_panel[i];
+            for (std::size_t j = 0; j < NR; j++) {
+                acc[i][j] += lhs_val * rhs_panel[j];
+            }
+        }
+        lhs_panel += MR;
+        rhs_panel += NR;
+    }
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < columns; j++) {
+            result[i][j] += acc[i][j];
+        }
+    }
+}
+
+// multiplies a packed lhs block with a packed rhs block
+static void macro_kernel(const double * packed_lhs, const double * packed_rhs,
+                         std::size_t rows, std::size_t columns,
+                         std::size_t depth, DenseMatrix & result,
+                         std::size_t row_begin, std::size_t column_begin) {
+    for (std::size_t jr = 0; jr < columns; jr += NR) {
+        std::size_t tile_columns = std::min(NR, columns - jr);
+        for (std::size_t ir = 0; ir < rows; ir += MR) {
+            std::size_t tile_rows = std::min(MR, rows - ir);
+            double * result_rows[MR] = {};
+            for (std::size_t r = 0; r < tile_rows; r++) {
+                result_rows[r] =
+                    result.row(row_begin + ir + r) + column_begin + jr;
+            }
+            micro_kernel(depth, packed_lhs + ir * depth,
+                         packed_rhs + jr * depth, result_rows, tile_rows,
+                         tile_columns);
+        }
+    }
+}
+
+void dense_gemm(const DenseMatrix & lhs, const DenseMatrix & rhs,
+                DenseMatrix & result, ThreadPool * pool) {
+    if (lhs.columns() != rhs.rows() || result.rows() != lhs.rows() ||
+        result.columns() != rhs.columns()) {
+        throw std::invalid_argument("Gemm: invalid matrix dimensions.");
+    }
+    std::size_t m = lhs.rows();
+    std::size_t n = rhs.columns();
+    std::size_t k = lhs.columns();
+
+    PackBuffer packed_rhs(std::min(KC, k) * round_up(std::min(NC, n), NR));
+    std::size_t row_blocks = (m + MC - 1) / MC;
+
+    for (std::size_t jc = 0; jc < n; jc += NC) {
+        std::size_t nc = std::min(NC, n - jc);
+        for (std::size_t pc = 0; pc < k; pc += KC) {
+            std::size_t kc = std::min(KC, k - pc);
+            pack_rhs(rhs, pc, kc, jc, nc, packed_rhs.data());
+            // row blocks write disjoint rows of the result, every task
+            // packs its lhs blocks into a buffer of its own
+            parallel_for(pool, 0, row_blocks, 1,
+                         [&](std::size_t first, std::size_t last) {
+                PackBuffer packed_lhs(round_up(std::min(MC, m), MR) * kc);
+                for (std::size_t block = first; block < last; block++) {
+                    std::size_t ic = block * MC;
+                    std::size_t mc = std::min(MC, m - ic);
+                    pack_lhs(lhs, ic, mc, pc, kc, packed_lhs.data());
+                    macro_kernel(packed_lhs.data(), packed_rhs.data(), mc, nc,
+                                 kc, result, ic, jc);
+                }
+            });
+        }
+    }
+}
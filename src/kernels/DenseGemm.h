@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../parallel/ThreadPool.h"
+#include "../representations/DenseMatrix.h"
+
+/**
+ * @brief Multiplies two dense matrices and adds the product to
+ *        <b>result</b>, ie. computes <b>result += lhs * rhs</b>. Works
+ *        directly on the row storage of the matrices. The computation is
+ *        blocked for the cache hierarchy, panels of both operands are packed
+ *        into contiguous buffers and the product of every pair of panels is
+ *        computed by a register tiled micro-kernel. Blocks of rows of
+ *        <b>lhs</b> are multiplied in parallel, each of them produces its own
+ *        rows of the result, so the result doesn't depend on the number of
+ *        threads.
+ * @param lhs Left hand side of the multiplication.
+ * @param rhs Right hand side of the multiplication.
+ * @param result Matrix into which the product is accumulated. Has to have
+ *               <b>lhs.rows()</b> rows and <b>rhs.columns()</b> columns.
+ * @param pool Thread pool to run on, the calling thread is used if it's a
+ *             nullptr.
+ * @throws std::invalid_argument if the dimensions of the matrices don't
+ *                               match.
+ */
+void dense_gemm(const DenseMatrix & lhs, const DenseMatrix & rhs,
+                DenseMatrix & result, ThreadPool * pool = nullptr);
@@ -0,0 +1,120 @@
+#include "ElementwiseKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ELEMENTWISE_X86
+#include <immintrin.h>
+#endif
+
+using AddKernel = void (*)(std::size_t, const double *, double, const double *,
+                           double *);
+using ScaleKernel = void (*)(std::size_t, double, const double *, double *);
+
+// every kernel multiplies and adds separately, fused multiply-add would round
+// differently from the scalar loop and from the sparse representations, the
+// build disables contracting them into one
+static void add_scalar(std::size_t n, const double * lhs, double alpha,
+                       const double * rhs, double * out) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = lhs[i] + alpha * rhs[i];
+    }
+}
+
+static void scale_scalar(std::size_t n, double alpha, const double * src,
+                         double * out) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = alpha * src[i];
+    }
+}
+
+#ifdef ELEMENTWISE_X86
+__attribute__((target("avx2"))) static void
+add_avx2(std::size_t n, const double * lhs, double alpha, const double * rhs,
+         double * out) {
+    __m256d factor = _mm256_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(lhs + i);
+        __m256d y = _mm256_loadu_pd(rhs + i);
+        _mm256_storeu_pd(out + i,
+                         _mm256_add_pd(x, _mm256_mul_pd(factor, y)));
+    }
+    add_scalar(n - i, lhs + i, alpha, rhs + i, out + i);
+}
+
+__attribute__((target("avx2"))) static void
+scale_avx2(std::size_t n, double alpha, const double * src, double * out) {
+    __m256d factor = _mm256_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i,
+                         _mm256_mul_pd(factor, _mm256_loadu_pd(src + i)));
+    }
+    scale_scalar(n - i, alpha, src + i, out + i);
+}
+
+__attribute__((target("avx512f"))) static void
+add_avx512(std::size_t n, const double * lhs, double alpha,
+           const double * rhs, double * out) {
+    __m512d factor = _mm512_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d x = _mm512_loadu_pd(lhs + i);
+        __m512d y = _mm512_loadu_pd(rhs + i);
+        _mm512_storeu_pd(out + i,
+                         _mm512_add_pd(x, _mm512_mul_pd(factor, y)));
+    }
+    add_scalar(n - i, lhs + i, alpha, rhs + i, out + i);
+}
+
+__attribute__((target("avx512f"))) static void
+scale_avx512(std::size_t n, double alpha, const double * src, double * out) {
+    __m512d factor = _mm512_set1_pd(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(out + i,
+                         _mm512_mul_pd(factor, _mm512_loadu_pd(src + i)));
+    }
+    scale_scalar(n - i, alpha, src + i, out + i);
+}
+#endif
+
+/**
+ * @brief The kernels picked for the CPU the program is running on.
+ */
+struct ElementwiseDispatch {
+    AddKernel add = add_scalar;
+    ScaleKernel scale = scale_scalar;
+    const char * name = "scalar";
+
+    ElementwiseDispatch() {
+#ifdef ELEMENTWISE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            add = add_avx512;
+            scale = scale_avx512;
+            name = "avx512";
+        } else if (__builtin_cpu_supports("avx2")) {
+            add = add_avx2;
+            scale = scale_avx2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+static const ElementwiseDispatch & dispatch() {
+    static const ElementwiseDispatch kernels;
+    return kernels;
+}
+
+void elementwise_add(std::size_t n, const double * lhs, double alpha,
+                     const double * rhs, double * out) {
+    dispatch().add(n, lhs, alpha, rhs, out);
+}
+
+void elementwise_scale(std::size_t n, double alpha, const double * src,
+                       double * out) {
+    dispatch().scale(n, alpha, src, out);
+}
+
+const char * elementwise_instruction_set() { return dispatch().name; }
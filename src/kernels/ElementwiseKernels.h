@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdlib>
+
+/**
+ * @brief Computes <b>out[i] = lhs[i] + alpha * rhs[i]</b> for <b>n</b>
+ *        elements. Vectorized with AVX-512 or AVX2 when the CPU supports
+ *        them, the instruction set is detected once at runtime, a scalar
+ *        loop is used otherwise. <b>out</b> may alias <b>lhs</b> or
+ *        <b>rhs</b>.
+ * @param n Number of elements.
+ * @param lhs First operand.
+ * @param alpha Scalar, by which <b>rhs</b> gets multiplied.
+ * @param rhs Second operand.
+ * @param out Destination of the result.
+ */
+void elementwise_add(std::size_t n, const double * lhs, double alpha,
+                     const double * rhs, double * out);
+
+/**
+ * @brief Computes <b>out[i] = alpha * src[i]</b> for <b>n</b> elements.
+ *        Vectorized the same way as <b>elementwise_add</b>. <b>out</b> may
+ *        alias <b>src</b>.
+ * @param n Number of elements.
+ * @param alpha Scalar, by which <b>src</b> gets multiplied.
+ * @param src Source operand.
+ * @param out Destination of the result.
+ */
+void elementwise_scale(std::size_t n, double alpha, const double * src,
+                       double * out);
+
+/**
+ * @brief Reports the instruction set picked for the element-wise kernels.
+ * @return "avx512", "avx2" or "scalar".
+ */
+const char * elementwise_instruction_set();
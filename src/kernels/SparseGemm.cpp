@@ -0,0 +1,168 @@
+#include "SparseGemm.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// minimal number of rows processed by a single task
+static inline constexpr std::size_t ROW_GRAIN = 64;
+
+static void check_dimensions(const MatrixMemoryRepr & lhs,
+                             const MatrixMemoryRepr & rhs,
+                             const MatrixMemoryRepr & result) {
+    if (lhs.columns() != rhs.rows() || result.rows() != lhs.rows() ||
+        result.columns() != rhs.columns()) {
+        throw std::invalid_argument("Gemm: invalid matrix dimensions.");
+    }
+}
+
+void sparse_dense_gemm(const CompressedSparseMatrix & lhs,
+                       const DenseMatrix & rhs, DenseMatrix & result,
+                       ThreadPool * pool) {
+    check_dimensions(lhs, rhs, result);
+    const auto & offsets = lhs.row_offsets();
+    const auto & columns = lhs.column_indices();
+    const auto & values = lhs.values();
+    std::size_t n = rhs.columns();
+
+    parallel_for(pool, 0, lhs.rows(), ROW_GRAIN,
+                 [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            double * result_row = result.row(i);
+            for (std::size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                double lhs_val = values[k];
+                const double * rhs_row = rhs.row(columns[k]);
+                for (std::size_t j = 0; j < n; j++) {
+                    result_row[j] += lhs_val * rhs_row[j];
+                }
+            }
+        }
+    });
+}
+
+void dense_sparse_gemm(const DenseMatrix & lhs,
+                       const CompressedSparseMatrix & rhs,
+                       DenseMatrix & result, ThreadPool * pool) {
+    check_dimensions(lhs, rhs, result);
+    const auto & offsets = rhs.row_offsets();
+    const auto & columns = rhs.column_indices();
+    const auto & values = rhs.values();
+
+    parallel_for(pool, 0, lhs.rows(), ROW_GRAIN,
+                 [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            const double * lhs_row = lhs.row(i);
+            double * result_row = result.row(i);
+            for (std::size_t k = 0; k < lhs.columns(); k++) {
+                double lhs_val = lhs_row[k];
+                if (lhs_val == 0) {
+                    continue;
+                }
+                for (std::size_t p = offsets[k]; p < offsets[k + 1]; p++) {
+                    result_row[columns[p]] += lhs_val * values[p];
+                }
+            }
+        }
+    });
+}
+
+// compressed rows of the product computed by a single task
+struct ProductRows {
+    std::vector<std::size_t> row_sizes;
+    std::vector<std::size_t> column_indices;
+    std::vector<double> values;
+};
+
+// computes rows [first, last) of lhs * rhs
+static void multiply_rows(const CompressedSparseMatrix & lhs,
+                          const CompressedSparseMatrix & rhs,
+                          std::size_t first, std::size_t last,
+                          ProductRows & out) {
+    const auto & lhs_offsets = lhs.row_offsets();
+    const auto & lhs_columns = lhs.column_indices();
+    const auto & lhs_values = lhs.values();
+    const auto & rhs_offsets = rhs.row_offsets();
+    const auto & rhs_columns = rhs.column_indices();
+    const auto & rhs_values = rhs.values();
+
+    // dense accumulator of the current row and the columns it touched
+    std::vector<double> accumulator(rhs.columns(), 0);
+    std::vector<bool> occupied(rhs.columns(), false);
+    std::vector<std::size_t> touched;
+    out.row_sizes.reserve(last - first);
+
+    for (std::size_t i = first; i < last; i++) {
+        std::size_t row_begin = out.values.size();
+        for (std::size_t k = lhs_offsets[i]; k < lhs_offsets[i + 1]; k++) {
+            double lhs_val = lhs_values[k];
+            std::size_t rhs_row = lhs_columns[k];
+            for (std::size_t p = rhs_offsets[rhs_row];
+                 p < rhs_offsets[rhs_row + 1]; p++) {
+                std::size_t column = rhs_columns[p];
+                if (!occupied[column]) {
+                    occupied[column] = true;
+                    touched.emplace_back(column);
+                }
+                accumulator[column] += lhs_val * rhs_values[p];
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+        for (const auto & column : touched) {
+            if (accumulator[column] != 0) {
+                out.column_indices.emplace_back(column);
+                out.values.emplace_back(accumulator[column]);
+            }
+            accumulator[column] = 0;
+            occupied[column] = false;
+        }
+        touched.clear();
+        out.row_sizes.emplace_back(out.values.size() - row_begin);
+    }
+}
+
+CompressedSparseMatrix sparse_gemm(const CompressedSparseMatrix & lhs,
+                                   const CompressedSparseMatrix & rhs,
+                                   ThreadPool * pool) {
+    if (lhs.columns() != rhs.rows()) {
+        throw std::invalid_argument("Gemm: invalid matrix dimensions.");
+    }
+    // rows are split into fixed parts, which are multiplied independently
+    // and concatenated in order afterwards
+    std::size_t rows = lhs.rows();
+    std::size_t parts = pool ? pool->size() * 4 : 1;
+    parts = std::max<std::size_t>(1, std::min(parts, rows / ROW_GRAIN));
+    std::size_t part_rows = (rows + parts - 1) / parts;
+    parts = (rows + part_rows - 1) / part_rows;
+
+    std::vector<ProductRows> products(parts);
+    parallel_for(pool, 0, parts, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t part = first; part < last; part++) {
+            std::size_t row_begin = part * part_rows;
+            multiply_rows(lhs, rhs, row_begin,
+                          std::min(rows, row_begin + part_rows),
+                          products[part]);
+        }
+    });
+
+    std::size_t non_zeroes = 0;
+    for (const auto & product : products) {
+        non_zeroes += product.values.size();
+    }
+    std::vector<std::size_t> row_offsets(1, 0);
+    std::vector<std::size_t> column_indices;
+    std::vector<double> values;
+    row_offsets.reserve(rows + 1);
+    column_indices.reserve(non_zeroes);
+    values.reserve(non_zeroes);
+    for (const auto & product : products) {
+        for (const auto & size : product.row_sizes) {
+            row_offsets.emplace_back(row_offsets.back() + size);
+        }
+        column_indices.insert(column_indices.end(),
+                              product.column_indices.begin(),
+                              product.column_indices.end());
+        values.insert(values.end(), product.values.begin(),
+                      product.values.end());
+    }
+    return {rows, rhs.columns(), std::move(row_offsets),
+            std::move(column_indices), std::move(values)};
+}
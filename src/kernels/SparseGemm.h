@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../parallel/ThreadPool.h"
+#include "../representations/CompressedSparseMatrix.h"
+#include "../representations/DenseMatrix.h"
+
+/**
+ * @brief Multiplies a sparse matrix by a dense one (SpMM) and adds the
+ *        product to <b>result</b>. Every non-zero element of <b>lhs</b>
+ *        scales a row of <b>rhs</b>, so the cost is proportional to
+ *        <b>lhs.nnz * rhs.columns()</b>.
+ * @param lhs Sparse left hand side of the multiplication.
+ * @param rhs Dense right hand side of the multiplication.
+ * @param result Matrix into which the product is accumulated. Has to have
+ *               <b>lhs.rows()</b> rows and <b>rhs.columns()</b> columns.
+ * @param pool Thread pool to run on, rows of the result are computed in
+ *             parallel. The calling thread is used if it's a nullptr.
+ * @throws std::invalid_argument if the dimensions of the matrices don't
+ *                               match.
+ */
+void sparse_dense_gemm(const CompressedSparseMatrix & lhs,
+                       const DenseMatrix & rhs, DenseMatrix & result,
+                       ThreadPool * pool = nullptr);
+
+/**
+ * @brief Multiplies a dense matrix by a sparse one and adds the product to
+ *        <b>result</b>. Every non-zero element of <b>lhs</b> scales a sparse
+ *        row of <b>rhs</b>, zero elements of <b>lhs</b> are skipped.
+ * @param lhs Dense left hand side of the multiplication.
+ * @param rhs Sparse right hand side of the multiplication.
+ * @param result Matrix into which the product is accumulated. Has to have
+ *               <b>lhs.rows()</b> rows and <b>rhs.columns()</b> columns.
+ * @param pool Thread pool to run on, rows of the result are computed in
+ *             parallel. The calling thread is used if it's a nullptr.
+ * @throws std::invalid_argument if the dimensions of the matrices don't
+ *                               match.
+ */
+void dense_sparse_gemm(const DenseMatrix & lhs,
+                       const CompressedSparseMatrix & rhs,
+                       DenseMatrix & result, ThreadPool * pool = nullptr);
+
+/**
+ * @brief Multiplies two sparse matrices (SpGEMM) using Gustavson's
+ *        row-wise algorithm. Every row of the product is accumulated in a
+ *        dense work array from the rows of <b>rhs</b> selected by the
+ *        non-zero elements of the same row of <b>lhs</b>, so the cost is
+ *        proportional to the number of multiplied non-zero pairs.
+ * @param lhs Left hand side of the multiplication.
+ * @param rhs Right hand side of the multiplication.
+ * @param pool Thread pool to run on, blocks of rows of the product are
+ *             computed in parallel and concatenated afterwards. The calling
+ *             thread is used if it's a nullptr.
+ * @return The product in a compressed sparse representation.
+ * @throws std::invalid_argument if the dimensions of the matrices don't
+ *                               match.
+ */
+CompressedSparseMatrix sparse_gemm(const CompressedSparseMatrix & lhs,
+                                   const CompressedSparseMatrix & rhs,
+                                   ThreadPool * pool = nullptr);
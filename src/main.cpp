@@ -1,24 +1,79 @@
 #include "calculator/MatrixCalculator.h"
+#include "calculator/OutputBuffer.h"
 #include <csignal>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <vector>
 #include "exceptions/QuitSignal.h"
 
+// size of the input and output buffers of the batch mode
+static constexpr std::size_t BATCH_BUFFER_SIZE = 1 << 20;
+
 //http://vyuka.bernhauer.cz/pa2-clanky/semestralni-prace
 void signal_handler(int) {
     throw QuitSignal();
 }
 
+// evaluates a script with buffered input and output, returns the number of
+// lines which failed
+static std::size_t run_batch(const std::string & script_file, bool keep_going,
+                             const std::string & config) {
+    // the buffer has to be set before the file is opened
+    std::vector<char> input_buffer(BATCH_BUFFER_SIZE);
+    std::ifstream script;
+    script.rdbuf()->pubsetbuf(input_buffer.data(), input_buffer.size());
+    script.open(script_file);
+    if (!script) {
+        throw std::runtime_error("Couldn't open file: " + script_file);
+    }
+    OutputBuffer output_buffer(std::cout.rdbuf(), BATCH_BUFFER_SIZE);
+    std::ostream output(&output_buffer);
+    MatrixCalculator calculator(script, output, config);
+    return calculator.run_script(!keep_going, std::cerr);
+}
+
+// usage: MatrixCalculator [config]
+//        MatrixCalculator --batch SCRIPT [--keep-going] [config]
 int main(int argc, char * argv[]){
-    if (argc > 2){
-        std::cerr << "Invalid number of command line arguments." << std::endl;
+    std::string config;
+    std::string script;
+    bool batch = false;
+    bool keep_going = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--batch")) {
+            if (i + 1 == argc) {
+                std::cerr << "Missing script after --batch." << std::endl;
+                return EXIT_FAILURE;
+            }
+            batch = true;
+            script = argv[++i];
+        } else if (!std::strcmp(argv[i], "--keep-going")) {
+            keep_going = true;
+        } else if (config.empty()) {
+            config = argv[i];
+        } else {
+            std::cerr << "Invalid number of command line arguments." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (keep_going && !batch) {
+        std::cerr << "--keep-going can only be used with --batch." << std::endl;
         return EXIT_FAILURE;
     }
 
     std::signal(SIGTERM, signal_handler);
     std::signal(SIGINT, signal_handler);
+    // the calculator doesn't use C stdio, unsynced streams read whole
+    // buffers instead of single characters
+    std::ios::sync_with_stdio(false);
 
     try {
-        MatrixCalculator calculator(std::cin, std::cout, argc == 2 ? argv[1] : "");
+        if (batch) {
+            return run_batch(script, keep_going, config) ? EXIT_FAILURE
+                                                         : EXIT_SUCCESS;
+        }
+        MatrixCalculator calculator(std::cin, std::cout, config);
         calculator.start();
     } catch (std::exception & e){
         std::cerr << e.what() << std::endl;
@@ -10,6 +10,7 @@
 #include "special_cases/MatrixOpExport.h"
 #include "special_cases/MatrixOpImport.h"
 #include "special_cases/MatrixOpPrint.h"
+#include "special_cases/MatrixOpUpdate.h"
 #include "two_args/MatrixOpMinus.h"
 #include "two_args/MatrixOpMul.h"
 #include "two_args/MatrixOpPlus.h"
@@ -30,6 +31,7 @@ OperationFactory::OperationFactory() {
     _operations.emplace("PRINT", new MatrixOpPrint);
     _operations.emplace("EXPORT", new MatrixOpExport);
     _operations.emplace("IMPORT", new MatrixOpImport);
+    _operations.emplace("UPDATE", new MatrixOpUpdate);
     _operations.emplace("=", new MatrixOpAssign);
 
 }
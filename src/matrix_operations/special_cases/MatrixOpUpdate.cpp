@@ -0,0 +1,7 @@
+#include "MatrixOpUpdate.h"
+
+MatrixOpUpdate::MatrixOpUpdate() : MatrixOpSpecial("UPDATE") {}
+
+Matrix MatrixOpUpdate::evaluate(const std::vector<Matrix> &) const {
+    return {0};
+}
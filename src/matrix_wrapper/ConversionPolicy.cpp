@@ -0,0 +1,46 @@
+#include "ConversionPolicy.h"
+#include <cmath>
+#include <stdexcept>
+
+ConversionPolicy::ConversionPolicy(double sparse_ratio)
+    : ConversionPolicy(sparse_ratio, sparse_ratio) {}
+
+ConversionPolicy::ConversionPolicy(double sparse_ratio, double dense_ratio)
+    : _sparse_ratio(sparse_ratio), _dense_ratio(dense_ratio) {
+    if (sparse_ratio < 0 || sparse_ratio > 1 || dense_ratio < 0 ||
+        dense_ratio > sparse_ratio) {
+        throw std::invalid_argument("Invalid ratios of conversion policy.");
+    }
+}
+
+bool ConversionPolicy::prefers_sparse(std::size_t nnz, std::size_t rows,
+                                      std::size_t columns,
+                                      bool is_sparse) const {
+    double ratio = is_sparse ? _dense_ratio : _sparse_ratio;
+    return nnz <= (1 - ratio) * rows * columns;
+}
+
+std::size_t
+ConversionPolicy::expected_product_nnz(const MatrixMemoryRepr & lhs,
+                                       const MatrixMemoryRepr & rhs) {
+    std::size_t depth = lhs.columns();
+    if (!depth || !lhs.rows() || !rhs.columns()) {
+        return 0;
+    }
+    // an element of the product is zero if none of the depth products
+    // of its row and column hits two non-zeroes
+    double lhs_density = double(lhs.nnz()) / (lhs.rows() * depth);
+    double rhs_density = double(rhs.nnz()) / (depth * rhs.columns());
+    double fill = -std::expm1(depth * std::log1p(-lhs_density * rhs_density));
+    return fill * lhs.rows() * rhs.columns();
+}
+
+bool ConversionPolicy::predicts_dense_product(
+    const MatrixMemoryRepr & lhs, const MatrixMemoryRepr & rhs) const {
+    return !prefers_sparse(expected_product_nnz(lhs, rhs), lhs.rows(),
+                           rhs.columns(), true);
+}
+
+double ConversionPolicy::sparse_ratio() const { return _sparse_ratio; }
+
+double ConversionPolicy::dense_ratio() const { return _dense_ratio; }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../representations/MatrixMemoryRepr.h"
+#include <cstdlib>
+
+/**
+ * @brief Decides, which representation a matrix should use. A dense matrix
+ *        becomes sparse once at least <b>sparse_ratio</b>*rows*columns of
+ *        its elements are zero, a sparse matrix becomes dense once fewer than
+ *        <b>dense_ratio</b>*rows*columns of its elements are zero. Matrices in
+ *        between keep their representation, so results close to a threshold
+ *        don't flip between representations on every operation.
+ */
+class ConversionPolicy {
+  public:
+    ConversionPolicy() = delete;
+
+    /**
+     * @brief Creates a policy with a single threshold, ie. without the band,
+     *        in which matrices keep their representation.
+     * @param sparse_ratio Ratio of zeroes, at which a matrix is sparse.
+     * @throws std::invalid_argument if the ratio is outside of [0, 1].
+     */
+    explicit ConversionPolicy(double sparse_ratio);
+
+    /**
+     * @brief Creates a policy with separate thresholds for both directions.
+     * @param sparse_ratio Ratio of zeroes, at which a dense matrix becomes
+     *                     sparse.
+     * @param dense_ratio Ratio of zeroes, under which a sparse matrix
+     *                    becomes dense.
+     * @throws std::invalid_argument if the ratios are outside of [0, 1] or
+     *                               <b>dense_ratio</b> is greater than
+     *                               <b>sparse_ratio</b>.
+     */
+    ConversionPolicy(double sparse_ratio, double dense_ratio);
+
+    /**
+     * @brief Decides, whether a matrix should be stored as a sparse matrix.
+     * @param nnz Number of non-zero elements of the matrix.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param is_sparse Whether the matrix is currently stored as sparse.
+     * @return True if the matrix should be sparse, false if dense.
+     */
+    bool prefers_sparse(std::size_t nnz, std::size_t rows, std::size_t columns,
+                        bool is_sparse) const;
+
+    /**
+     * @brief Estimates the number of non-zeroes of the product of two
+     *        matrices from the densities of the operands, presuming their
+     *        non-zeroes are spread uniformly.
+     * @param lhs Left operand of the product.
+     * @param rhs Right operand of the product.
+     * @return Expected number of non-zero elements of the product.
+     */
+    static std::size_t expected_product_nnz(const MatrixMemoryRepr & lhs,
+                                            const MatrixMemoryRepr & rhs);
+
+    /**
+     * @brief Decides, whether the product of two sparse matrices should be
+     *        computed into a dense matrix, see
+     *        <b>expected_product_nnz</b>.
+     * @param lhs Left operand of the product.
+     * @param rhs Right operand of the product.
+     * @return True if the product is expected to be dense.
+     */
+    bool predicts_dense_product(const MatrixMemoryRepr & lhs,
+                                const MatrixMemoryRepr & rhs) const;
+
+    /**
+     * @brief Getter for the ratio of zeroes, at which a matrix becomes sparse.
+     * @return The sparse ratio.
+     */
+    double sparse_ratio() const;
+
+    /**
+     * @brief Getter for the ratio of zeroes, under which a matrix becomes
+     *        dense.
+     * @return The dense ratio.
+     */
+    double dense_ratio() const;
+
+  private:
+    /**
+     * @brief Ratio of zeroes, at which a dense matrix becomes sparse.
+     */
+    double _sparse_ratio;
+
+    /**
+     * @brief Ratio of zeroes, under which a sparse matrix becomes dense.
+     */
+    double _dense_ratio;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "LUDecomposition.h"
+#include <memory>
+#include <optional>
+
+class Matrix;
+
+/**
+ * @brief Results derived from the contents of a matrix, which are expensive
+ *        to compute. Every member is computed lazily on its first use. The
+ *        cache is shared by all copies of a matrix, as the contents of a
+ *        matrix never change once it's created. Assigning a different matrix
+ *        replaces the cache along with the contents.\n
+ *        Decompositions are dense, they are kept only for dense matrices,
+ *        whose size they don't exceed, and only while something may still
+ *        be derived from them.
+ */
+struct FactorizationCache {
+
+    /**
+     * @brief LU decomposition of the matrix with exact pivoting, see
+     *        <b>LUDecomposition::Pivoting</b>. Released once both
+     *        <b>det</b> and <b>inverse</b> are known.
+     */
+    std::shared_ptr<const LUDecomposition> lu;
+
+    /**
+     * @brief Rank-revealing LU decomposition of the matrix, used for its
+     *        rank and row echelon form.
+     */
+    std::shared_ptr<const LUDecomposition> echelon;
+
+    /**
+     * @brief Determinant of the matrix, computed from <b>lu</b>.
+     */
+    std::optional<double> det;
+
+    /**
+     * @brief Rank of the matrix, computed from <b>echelon</b>.
+     */
+    std::optional<std::size_t> rank;
+
+    /**
+     * @brief Inverse of the matrix, computed from <b>lu</b>.
+     */
+    std::shared_ptr<const Matrix> inverse;
+};
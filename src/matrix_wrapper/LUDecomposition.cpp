@@ -0,0 +1,206 @@
+#include "LUDecomposition.h"
+#include "../kernels/ElementwiseKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+// number of columns eliminated before the rest of the matrix gets updated
+static inline constexpr std::size_t PANEL = 32;
+
+// columns of the trailing matrix updated at once, a tile of all pivot rows
+// of a panel (PANEL x COLUMN_TILE) should fit into L2
+static inline constexpr std::size_t COLUMN_TILE = 256;
+
+// columns of the inverse solved by a single task, a multiple of the vector
+// width, so the result doesn't depend on the partitioning
+static inline constexpr std::size_t SOLVE_TILE = 64;
+
+static DenseMatrix to_dense(const MatrixMemoryRepr & matrix) {
+    if (auto dense = dynamic_cast<const DenseMatrix *>(&matrix)) {
+        return *dense;
+    }
+    return {matrix.begin(), matrix.end()};
+}
+
+LUDecomposition::LUDecomposition(const MatrixMemoryRepr & matrix,
+                                 Pivoting pivoting, ThreadPool * pool)
+    : _factors(to_dense(matrix)), _permutation(matrix.rows()), _swaps(0),
+      _tolerance(0), _pool(pool) {
+    std::iota(_permutation.begin(), _permutation.end(), 0);
+    if (pivoting == Pivoting::EXACT) {
+        factorize();
+        return;
+    }
+
+    double max_abs = 0;
+    for (std::size_t i = 0; i < _factors.rows(); i++) {
+        const double * row = _factors.row(i);
+        for (std::size_t j = 0; j < _factors.columns(); j++) {
+            max_abs = std::max(max_abs, std::abs(row[j]));
+        }
+    }
+    _tolerance = std::max(_factors.rows(), _factors.columns()) *
+                 std::numeric_limits<double>::epsilon() * max_abs;
+    factorize();
+}
+
+void LUDecomposition::factorize() {
+    std::size_t m = _factors.rows();
+    std::size_t n = _factors.columns();
+    std::size_t r = 0;
+
+    for (std::size_t j0 = 0; j0 < n && r < m; j0 += PANEL) {
+        std::size_t j1 = std::min(n, j0 + PANEL);
+        std::size_t r0 = r;
+        std::size_t first_pivot = _pivot_columns.size();
+
+        // unblocked elimination of the panel, only its own columns are
+        // updated
+        for (std::size_t j = j0; j < j1 && r < m; j++) {
+            std::size_t pivot_row = r;
+            for (std::size_t i = r + 1; i < m; i++) {
+                if (std::abs(_factors.row(i)[j]) >
+                    std::abs(_factors.row(pivot_row)[j])) {
+                    pivot_row = i;
+                }
+            }
+            if (std::abs(_factors.row(pivot_row)[j]) <= _tolerance) {
+                continue;
+            }
+            if (pivot_row != r) {
+                _factors.swap_rows(r, pivot_row);
+                std::swap(_permutation[r], _permutation[pivot_row]);
+                ++_swaps;
+            }
+            const double * top = _factors.row(r);
+            for (std::size_t i = r + 1; i < m; i++) {
+                double * row = _factors.row(i);
+                double multiplier = row[j] / top[j];
+                row[j] = multiplier;
+                for (std::size_t k = j + 1; k < j1; k++) {
+                    row[k] -= multiplier * top[k];
+                }
+            }
+            _pivot_columns.emplace_back(j);
+            ++r;
+        }
+        if (j1 == n || r == r0) {
+            continue;
+        }
+
+        // the remaining columns of the pivot rows: forward substitution
+        // with the unit lower triangle of the panel
+        for (std::size_t t = r0 + 1; t < r; t++) {
+            double * row = _factors.row(t);
+            for (std::size_t s = r0; s < t; s++) {
+                double multiplier = row[_pivot_columns[first_pivot + s - r0]];
+                if (multiplier != 0) {
+                    elementwise_add(n - j1, row + j1, -multiplier,
+                                    _factors.row(s) + j1, row + j1);
+                }
+            }
+        }
+
+        // rank update of the trailing rows by all pivot rows of the panel,
+        // tiled by columns so that the pivot rows stay in cache
+        std::size_t work_per_row = (n - j1) * (r - r0);
+        std::size_t grain =
+            std::max<std::size_t>(1, (std::size_t(1) << 16) / work_per_row);
+        parallel_for(_pool, r, m, grain,
+                     [&](std::size_t first, std::size_t last) {
+            for (std::size_t c0 = j1; c0 < n; c0 += COLUMN_TILE) {
+                std::size_t width = std::min(COLUMN_TILE, n - c0);
+                for (std::size_t i = first; i < last; i++) {
+                    double * row = _factors.row(i);
+                    for (std::size_t s = r0; s < r; s++) {
+                        double multiplier =
+                            row[_pivot_columns[first_pivot + s - r0]];
+                        if (multiplier != 0) {
+                            elementwise_add(width, row + c0, -multiplier,
+                                            _factors.row(s) + c0, row + c0);
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+std::size_t LUDecomposition::rank() const { return _pivot_columns.size(); }
+
+double LUDecomposition::det() const {
+    if (_factors.rows() != _factors.columns()) {
+        throw std::logic_error("Determinant is undefined for non-square matrices.");
+    }
+    if (rank() != _factors.rows()) {
+        return 0;
+    }
+    double det = _swaps % 2 ? -1 : 1;
+    for (std::size_t i = 0; i < _factors.rows(); i++) {
+        det *= _factors.row(i)[i];
+    }
+    return det;
+}
+
+DenseMatrix LUDecomposition::inverse() const {
+    if (_factors.rows() != _factors.columns()) {
+        throw std::logic_error("Non-square matrices cannot be inverted.");
+    }
+    if (rank() != _factors.rows()) {
+        throw std::runtime_error("Matrix is not invertible.");
+    }
+    std::size_t n = _factors.rows();
+    DenseMatrix result(n, n);
+    for (std::size_t i = 0; i < n; i++) {
+        result.row(i)[_permutation[i]] = 1;
+    }
+
+    // columns of the inverse are independent, tiles of them are solved
+    // in parallel
+    std::size_t tiles = (n + SOLVE_TILE - 1) / SOLVE_TILE;
+    parallel_for(_pool, 0, tiles, 1, [&](std::size_t first, std::size_t last) {
+        std::size_t c0 = first * SOLVE_TILE;
+        std::size_t width = std::min(n, last * SOLVE_TILE) - c0;
+        // L * Y = P
+        for (std::size_t i = 1; i < n; i++) {
+            const double * factors = _factors.row(i);
+            double * row = result.row(i) + c0;
+            for (std::size_t s = 0; s < i; s++) {
+                if (factors[s] != 0) {
+                    elementwise_add(width, row, -factors[s],
+                                    result.row(s) + c0, row);
+                }
+            }
+        }
+        // U * X = Y
+        for (std::size_t i = n; i-- > 0;) {
+            const double * factors = _factors.row(i);
+            double * row = result.row(i) + c0;
+            for (std::size_t s = i + 1; s < n; s++) {
+                if (factors[s] != 0) {
+                    elementwise_add(width, row, -factors[s],
+                                    result.row(s) + c0, row);
+                }
+            }
+            for (std::size_t k = 0; k < width; k++) {
+                // adding zero turns negative zeroes into positive ones
+                row[k] = row[k] / factors[i] + 0.0;
+            }
+        }
+    });
+    return result;
+}
+
+DenseMatrix LUDecomposition::upper() const {
+    DenseMatrix result(_factors.rows(), _factors.columns());
+    for (std::size_t t = 0; t < rank(); t++) {
+        const double * factors = _factors.row(t);
+        double * row = result.row(t);
+        for (std::size_t k = _pivot_columns[t]; k < _factors.columns(); k++) {
+            row[k] = std::abs(factors[k]) > _tolerance ? factors[k] : 0;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../parallel/ThreadPool.h"
+#include "../representations/DenseMatrix.h"
+#include "../representations/MatrixMemoryRepr.h"
+#include <vector>
+
+/**
+ * @brief LU factorization with partial pivoting, <b>PA = LU</b>, of a matrix
+ *        of arbitrary dimensions. Columns without a usable pivot are skipped,
+ *        so <b>U</b> is in row echelon form and the number of pivots is the
+ *        rank of the matrix. Which pivots are usable depends on
+ *        <b>Pivoting</b>. The factorization is blocked, columns are eliminated in
+ *        panels and the rest of the matrix is updated once per panel, in
+ *        parallel over blocks of rows.
+ */
+class LUDecomposition {
+  public:
+
+    /**
+     * @brief Decides, which pivots are usable.\n
+     *        <b>EXACT</b> - Every non-zero pivot is used, like LAPACK's getrf
+     *                       does. Used for the determinant and the inverse,
+     *                       which are defined for any regular matrix.\n
+     *        <b>RANK_REVEALING</b> - Values, whose magnitude doesn't exceed
+     *                       <b>max(rows, columns) * epsilon * max|a_ij|</b>,
+     *                       are considered to be zero. Used for the rank and
+     *                       the row echelon form, so that round-off errors
+     *                       don't count as independent rows.
+     */
+    enum class Pivoting { EXACT, RANK_REVEALING };
+
+    /**
+     * @brief Factorizes a copy of the provided matrix.
+     * @param matrix Matrix to factorize.
+     * @param pivoting Decides, which pivots are usable.
+     * @param pool Thread pool used for the factorization and for computing
+     *             the inverse, the calling thread is used if it's a nullptr.
+     *             Has to outlive the decomposition.
+     */
+    LUDecomposition(const MatrixMemoryRepr & matrix, Pivoting pivoting,
+                    ThreadPool * pool = nullptr);
+
+    /**
+     * @brief Getter for the rank of the factorized matrix.
+     * @return Number of pivots found during the factorization.
+     */
+    std::size_t rank() const;
+
+    /**
+     * @brief Calculates the determinant as a product of the diagonal of
+     *        <b>U</b>, its sign is determined by the number of row swaps.
+     * @return Determinant of the factorized matrix, zero if it's singular.
+     * @throws std::logic_error if the factorized matrix isn't square.
+     */
+    double det() const;
+
+    /**
+     * @brief Calculates the inverse matrix by solving <b>LUX = P</b> with
+     *        forward and backward substitution.
+     * @return The inverse of the factorized matrix.
+     * @throws std::logic_error if the factorized matrix isn't square.
+     * @throws std::runtime_error if the factorized matrix is singular.
+     */
+    DenseMatrix inverse() const;
+
+    /**
+     * @brief Returns the factor <b>U</b>, ie. the factorized matrix eliminated
+     *        into row echelon form. Values considered to be zero are replaced
+     *        by exact zeroes.
+     * @return Upper factor of the decomposition.
+     */
+    DenseMatrix upper() const;
+
+  private:
+
+    /**
+     * @brief Both factors stored in place of the factorized matrix. <b>U</b>
+     *        occupies the pivot rows from their pivot columns to the right,
+     *        multipliers of <b>L</b> are stored below the pivots.
+     */
+    DenseMatrix _factors;
+
+    /**
+     * @brief Column of the pivot of every pivot row, in increasing order.
+     */
+    std::vector<std::size_t> _pivot_columns;
+
+    /**
+     * @brief Row <b>i</b> of <b>PA</b> is row <b>_permutation[i]</b> of the
+     *        factorized matrix.
+     */
+    std::vector<std::size_t> _permutation;
+
+    /**
+     * @brief Number of row swaps performed during the factorization.
+     */
+    std::size_t _swaps;
+
+    /**
+     * @brief Values of at most this magnitude are considered to be zero,
+     *        zero for <b>Pivoting::EXACT</b>.
+     */
+    double _tolerance;
+
+    /**
+     * @brief A non-owning pointer to the thread pool used by <b>inverse</b>.
+     */
+    ThreadPool * _pool;
+
+    /**
+     * @brief Runs the blocked factorization on <b>_factors</b>.
+     */
+    void factorize();
+};
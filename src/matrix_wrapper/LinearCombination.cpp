@@ -0,0 +1,59 @@
+#include "LinearCombination.h"
+#include <stdexcept>
+
+LinearCombination::LinearCombination(const Matrix & matrix) {
+    _terms.emplace_back(1, matrix);
+}
+
+std::size_t LinearCombination::rows() const {
+    return _terms.front().second.rows();
+}
+
+std::size_t LinearCombination::columns() const {
+    return _terms.front().second.columns();
+}
+
+bool LinearCombination::is_scalar() const {
+    return rows() == 1 && columns() == 1;
+}
+
+LinearCombination & LinearCombination::operator+=(const LinearCombination & rhs) {
+    if (rows() != rhs.rows() || columns() != rhs.columns()) {
+        throw std::invalid_argument(
+            "Matrix addition: dimensions are not matching.");
+    }
+    _terms.insert(_terms.end(), rhs._terms.begin(), rhs._terms.end());
+    return *this;
+}
+
+LinearCombination & LinearCombination::operator-=(const LinearCombination & rhs) {
+    if (rows() != rhs.rows() || columns() != rhs.columns()) {
+        throw std::invalid_argument(
+            "Matrix subtraction: dimensions are not matching.");
+    }
+    for (const auto & [coefficient, matrix] : rhs._terms) {
+        _terms.emplace_back(-coefficient, matrix);
+    }
+    return *this;
+}
+
+LinearCombination & LinearCombination::operator*=(double value) {
+    for (auto & term : _terms) {
+        term.first *= value;
+    }
+    return *this;
+}
+
+Matrix LinearCombination::evaluate() const {
+    return Matrix::linear_combination(_terms);
+}
+
+double LinearCombination::scalar_value() const {
+    if (!is_scalar()) {
+        throw std::logic_error("Linear combination is not a scalar.");
+    }
+    double value = 0;
+    evaluate().for_each_nonzero(
+        [&value](std::size_t, std::size_t, double val) { value = val; });
+    return value;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Matrix.h"
+#include <utility>
+#include <vector>
+
+/**
+ * @brief An unevaluated linear combination of matrices,
+ *        <b>c_1 * M_1 + c_2 * M_2 + ...</b>. Chains of additions,
+ *        subtractions and scalar multiplications are collected into a single
+ *        combination and evaluated in one pass by
+ *        <b>Matrix::linear_combination</b>, so no intermediate results are
+ *        materialized. Operands are held as copies of <b>Matrix</b>, which
+ *        share their representations.
+ */
+class LinearCombination {
+  public:
+
+    /**
+     * @brief Creates a combination consisting of <b>1 * matrix</b>.
+     * @param matrix The only operand of the combination.
+     */
+    explicit LinearCombination(const Matrix & matrix);
+
+    /**
+     * @brief Getter for the number of rows of the combined matrices.
+     * @return Number of rows.
+     */
+    std::size_t rows() const;
+
+    /**
+     * @brief Getter for the number of columns of the combined matrices.
+     * @return Number of columns.
+     */
+    std::size_t columns() const;
+
+    /**
+     * @brief Determines, whether the combination evaluates to a number, ie.
+     *        a 1x1 matrix.
+     * @return True if the combined matrices have 1x1 dimensions.
+     */
+    bool is_scalar() const;
+
+    /**
+     * @brief Appends the terms of <b>rhs</b> to the combination.
+     * @param rhs Combination to add.
+     * @return <b>*this</b>
+     * @throws std::invalid_argument if the dimensions of the combinations
+     *                               don't match.
+     */
+    LinearCombination & operator+=(const LinearCombination & rhs);
+
+    /**
+     * @brief Appends the terms of <b>rhs</b> with negated coefficients to
+     *        the combination.
+     * @param rhs Combination to subtract.
+     * @return <b>*this</b>
+     * @throws std::invalid_argument if the dimensions of the combinations
+     *                               don't match.
+     */
+    LinearCombination & operator-=(const LinearCombination & rhs);
+
+    /**
+     * @brief Multiplies the coefficients of all terms by <b>value</b>.
+     * @param value Value to multiply the combination by.
+     * @return <b>*this</b>
+     */
+    LinearCombination & operator*=(double value);
+
+    /**
+     * @brief Evaluates the combination, see
+     *        <b>Matrix::linear_combination</b>.
+     * @return The resulting matrix.
+     */
+    Matrix evaluate() const;
+
+    /**
+     * @brief Evaluates a combination of 1x1 matrices into a number.
+     * @return Value of the only element of the result.
+     * @throws std::logic_error if the combination isn't a scalar.
+     */
+    double scalar_value() const;
+
+  private:
+
+    /**
+     * @brief Coefficients and operands of the combination.
+     */
+    std::vector<std::pair<double, Matrix>> _terms;
+};
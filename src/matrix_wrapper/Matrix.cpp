@@ -1,61 +1,78 @@
 #include "Matrix.h"
+#include "../kernels/DenseGemm.h"
+#include "../kernels/ElementwiseKernels.h"
+#include "../kernels/SparseGemm.h"
+#include "../parallel/ThreadPool.h"
+#include "../profiling/ProfileCounters.h"
+#include "../representations/CompressedSparseMatrix.h"
+#include "../representations/DenseMatrix.h"
 #include "../representations/MatrixMemoryRepr.h"
+#include "../representations/SparseMatrix.h"
 #include "MatrixFactory.h"
-#include <queue>
-#include <set>
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 
-constexpr auto default_capture = [](std::size_t, std::size_t) { return; };
-
-void Matrix::gem_swap_rows(
-    std::function<void(std::size_t, std::size_t)> && capture_fn) {
-
-    for (std::size_t i = 0, column_index = 0;
-         i < rows() && column_index < columns(); i++, column_index++) {
-        if (_matrix->at(i, column_index).value() == 0) {
-            for (std::size_t j = i; j < rows(); j++) {
-                for (std::size_t h = column_index; h < columns(); h++) {
-                    if (_matrix->at(i, h).value() == 0 &&
-                        _matrix->at(j, h).value() != 0) {
-                        _matrix->swap_rows(i, j);
-                        capture_fn(i, j);
-                        break;
-                    }
-                }
-            }
-        }
-    }
+// side of the square tiles, in which dense matrices are transposed
+static inline constexpr std::size_t TRANSPOSE_TILE = 32;
+
+// number of rows of the given length worth a task of their own
+static inline std::size_t elementwise_grain(std::size_t row_length) {
+    constexpr std::size_t elements_per_task = 1 << 14;
+    return std::max<std::size_t>(1, elements_per_task / row_length);
 }
 
-// https://www.math-cs.gordon.edu/courses/ma342/handouts/gauss.pdf
-void Matrix::gem_row_elim(
-    std::function<void(std::size_t, std::size_t)> && capture_fn) {
+// returns the sparse representation in the compressed format, map based
+// matrices are compressed into holder, nullptr is returned for other formats
+static const CompressedSparseMatrix *
+as_compressed(const MatrixMemoryRepr * repr,
+              std::unique_ptr<CompressedSparseMatrix> & holder) {
+    if (auto compressed = dynamic_cast<const CompressedSparseMatrix *>(repr)) {
+        return compressed;
+    }
+    if (dynamic_cast<const SparseMatrix *>(repr)) {
+        holder =
+            std::make_unique<CompressedSparseMatrix>(repr->begin(), repr->end());
+        return holder.get();
+    }
+    return nullptr;
+}
 
-    for (std::size_t i = 0; i < columns(); i++) {
-        for (std::size_t j = i + 1; j < rows(); j++) {
-            capture_fn(i, j);
-            double multiplier = _matrix->at(j, i).value();
-            for (std::size_t k = i; k < columns(); k++) {
-                _matrix->modify(
-                    j, k,
-                    (_matrix->at(j, k).value() * _matrix->at(i, i).value() -
-                     (multiplier * _matrix->at(i, k).value())));
-            }
-        }
+// computes lhs + alpha * rhs directly on the row storage, returns nullptr
+// if one of the operands isn't dense
+static std::unique_ptr<DenseMatrix> dense_add(const MatrixMemoryRepr * lhs,
+                                              double alpha,
+                                              const MatrixMemoryRepr * rhs,
+                                              ThreadPool * pool) {
+    auto dense_lhs = dynamic_cast<const DenseMatrix *>(lhs);
+    auto dense_rhs = dynamic_cast<const DenseMatrix *>(rhs);
+    if (!dense_lhs || !dense_rhs) {
+        return nullptr;
     }
+    auto result = std::make_unique<DenseMatrix>(lhs->rows(), lhs->columns());
+    parallel_for(pool, 0, lhs->rows(), elementwise_grain(lhs->columns()),
+                 [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; i++) {
+            elementwise_add(lhs->columns(), dense_lhs->row(i), alpha,
+                            dense_rhs->row(i), result->row(i));
+        }
+    });
+    return result;
 }
 
 void Matrix::optimize() {
+    auto start = std::chrono::steady_clock::now();
     auto new_ptr = _factory.convert(_matrix.get());
     if (new_ptr == _matrix.get()) {
         return;
     }
+    record_conversion(std::chrono::steady_clock::now() - start);
     _matrix.reset(new_ptr);
 }
 
 Matrix::Matrix(std::size_t rows, std::size_t columns, MatrixFactory factory)
     : _factory(factory) {
-    _matrix = std::unique_ptr<MatrixMemoryRepr>(
+    _matrix = std::shared_ptr<MatrixMemoryRepr>(
         _factory.get_initial_repr(rows, columns));
 }
 
@@ -63,7 +80,7 @@ Matrix::Matrix(std::initializer_list<std::initializer_list<double>> init,
                MatrixFactory factory)
     : _factory(factory) {
     _matrix =
-        std::unique_ptr<MatrixMemoryRepr>(_factory.get_initial_repr(init));
+        std::shared_ptr<MatrixMemoryRepr>(_factory.get_initial_repr(init));
 }
 
 Matrix::Matrix(const MatrixMemoryRepr & repr, MatrixFactory factory)
@@ -71,25 +88,64 @@ Matrix::Matrix(const MatrixMemoryRepr & repr, MatrixFactory factory)
     optimize();
 }
 
-Matrix::Matrix(IteratorWrapper begin, IteratorWrapper end,
-               MatrixFactory factory)
-    : _matrix(factory.get_initial_repr(std::move(begin), std::move(end))),
+Matrix::Matrix(std::size_t rows, std::size_t columns,
+               DenseMatrix::Buffer && data, MatrixFactory factory)
+    : _matrix(factory.get_initial_repr(rows, columns, std::move(data))),
+      _factory(factory) {}
+
+Matrix::Matrix(std::size_t rows, std::size_t columns,
+               std::vector<MatrixElement> && elements, MatrixFactory factory)
+    : _matrix(factory.get_initial_repr(rows, columns, std::move(elements))),
       _factory(factory) {}
 
+Matrix::Matrix(std::size_t rows, std::size_t columns,
+               std::vector<std::size_t> && row_offsets,
+               std::vector<std::size_t> && column_indices,
+               std::vector<double> && values, MatrixFactory factory)
+    : _matrix(factory.get_initial_repr(rows, columns, std::move(row_offsets),
+                                       std::move(column_indices),
+                                       std::move(values))),
+      _factory(factory) {}
+
+Matrix::Matrix(std::unique_ptr<MatrixMemoryRepr> repr, MatrixFactory factory)
+    : _matrix(std::move(repr)), _factory(factory) {
+    // dense results of the kernels are written through raw rows
+    if (auto dense = dynamic_cast<DenseMatrix *>(_matrix.get())) {
+        dense->recount_nonzeros();
+    }
+}
+
+MatrixMemoryRepr & Matrix::mutable_repr() {
+    if (_matrix.use_count() > 1) {
+        _matrix.reset(_matrix->clone());
+    }
+    _cache.reset();
+    return *_matrix;
+}
+
+Matrix Matrix::mutable_copy() const {
+    return {std::unique_ptr<MatrixMemoryRepr>(
+                _factory.get_mutable_repr(_matrix.get())),
+            _factory};
+}
+
 Matrix::Matrix(double val) : _factory(0.5) {
-    _matrix = std::unique_ptr<MatrixMemoryRepr>(_factory.get_initial_repr(val));
+    _matrix = std::shared_ptr<MatrixMemoryRepr>(_factory.get_initial_repr(val));
 }
 
 Matrix::Matrix(const Matrix & src)
-    : _matrix(src._matrix->clone()), _factory(src._factory) {}
+    : _matrix(src._matrix), _factory(src._factory),
+      _cache(src.shared_cache()) {}
 
 Matrix::Matrix(Matrix && src) noexcept
-    : _matrix(std::move(src._matrix)), _factory(src._factory) {}
+    : _matrix(std::move(src._matrix)), _factory(src._factory),
+      _cache(std::move(src._cache)) {}
 
 Matrix & Matrix::operator=(const Matrix & src) {
     if (this != &src) {
-        _matrix = std::unique_ptr<MatrixMemoryRepr>(src._matrix->clone());
+        _matrix = src._matrix;
         _factory = src._factory;
+        _cache = src.shared_cache();
     }
     return *this;
 }
@@ -98,6 +154,7 @@ Matrix & Matrix::operator=(Matrix && src) noexcept {
     if (this != &src) {
         _matrix = std::move(src._matrix);
         _factory = src._factory;
+        _cache = std::move(src._cache);
     }
     return *this;
 }
@@ -107,10 +164,18 @@ Matrix Matrix::operator+(const Matrix & other) const {
         throw std::invalid_argument(
             "Matrix addition: dimensions are not matching.");
     }
-    Matrix result(*this);
-    for (const auto & [pos, val] : other) {
-        result._matrix->add(pos.row, pos.column, val);
+    if (auto sum = dense_add(_matrix.get(), 1, other._matrix.get(),
+                             _factory.pool())) {
+        Matrix result(std::move(sum), _factory);
+        result.optimize();
+        return result;
     }
+    Matrix result = mutable_copy();
+    auto & repr = result.mutable_repr();
+    other.for_each_nonzero(
+        [&repr](std::size_t row, std::size_t column, double val) {
+            repr.add(row, column, val);
+        });
     result.optimize();
     return result;
 }
@@ -120,10 +185,18 @@ Matrix Matrix::operator-(const Matrix & other) const {
         throw std::invalid_argument(
             "Matrix subtraction: dimensions are not matching.");
     }
-    Matrix result(*this);
-    for (const auto & [pos, val] : other) {
-        result._matrix->add(pos.row, pos.column, val * -1);
+    if (auto difference = dense_add(_matrix.get(), -1, other._matrix.get(),
+                                    _factory.pool())) {
+        Matrix result(std::move(difference), _factory);
+        result.optimize();
+        return result;
     }
+    Matrix result = mutable_copy();
+    auto & repr = result.mutable_repr();
+    other.for_each_nonzero(
+        [&repr](std::size_t row, std::size_t column, double val) {
+            repr.add(row, column, val * -1);
+        });
     result.optimize();
     return result;
 }
@@ -141,34 +214,165 @@ Matrix Matrix::operator*(const Matrix & other) const {
         throw std::invalid_argument(
             "Matrix multiplication: invalid matrix dimensions.");
     }
-    Matrix result(rows(), other.columns(), _factory);
 
-    for (std::size_t i = 0; i < result.rows(); i++) {
-        for (std::size_t j = 0; j < result.columns(); j++) {
-            double result_element = 0;
-            for (std::size_t k = 0; k < columns(); k++) {
-                result_element +=
-                    _matrix->at(i, k).value() * other._matrix->at(k, j).value();
-            }
-            result._matrix->modify(i, j, result_element);
+    auto dense_lhs = dynamic_cast<const DenseMatrix *>(_matrix.get());
+    auto dense_rhs = dynamic_cast<const DenseMatrix *>(other._matrix.get());
+    std::unique_ptr<CompressedSparseMatrix> lhs_holder, rhs_holder;
+    auto sparse_lhs = as_compressed(_matrix.get(), lhs_holder);
+    auto sparse_rhs = as_compressed(other._matrix.get(), rhs_holder);
+
+    // products of sparse matrices may well be dense, compute those into a
+    // dense matrix right away instead of converting the sparse result
+    std::unique_ptr<DenseMatrix> dense_holder;
+    if (sparse_lhs && sparse_rhs &&
+        _factory.policy().predicts_dense_product(*sparse_lhs, *sparse_rhs)) {
+        dense_holder = std::make_unique<DenseMatrix>(other.rows(),
+                                                     other.columns());
+        sparse_rhs->for_each_nonzero(
+            [&](std::size_t row, std::size_t column, double val) {
+                dense_holder->row(row)[column] = val;
+            });
+        dense_rhs = dense_holder.get();
+        sparse_rhs = nullptr;
+    }
+
+    std::unique_ptr<MatrixMemoryRepr> product;
+    if (sparse_lhs && sparse_rhs) {
+        product = std::make_unique<CompressedSparseMatrix>(
+            sparse_gemm(*sparse_lhs, *sparse_rhs, _factory.pool()));
+    } else if ((dense_lhs || sparse_lhs) && (dense_rhs || sparse_rhs)) {
+        auto dense_product =
+            std::make_unique<DenseMatrix>(rows(), other.columns());
+        if (dense_lhs && dense_rhs) {
+            dense_gemm(*dense_lhs, *dense_rhs, *dense_product,
+                       _factory.pool());
+        } else if (sparse_lhs) {
+            sparse_dense_gemm(*sparse_lhs, *dense_rhs, *dense_product,
+                              _factory.pool());
+        } else {
+            dense_sparse_gemm(*dense_lhs, *sparse_rhs, *dense_product,
+                              _factory.pool());
         }
+        product = std::move(dense_product);
     }
+    if (!product) {
+        // every representation is either dense or convertible to CSR
+        throw std::logic_error(
+            "Matrix multiplication: unsupported matrix representation.");
+    }
+    Matrix result(std::move(product), _factory);
     result.optimize();
     return result;
 }
 
 Matrix operator*(double scalar, const Matrix & mx) {
-    Matrix result(mx);
-    for (const auto & [pos, val] : mx) {
-        double new_value = val * scalar;
-        result._matrix->modify(pos.row, pos.column, new_value);
+    if (auto dense = dynamic_cast<const DenseMatrix *>(mx._matrix.get())) {
+        auto scaled = std::make_unique<DenseMatrix>(mx.rows(), mx.columns());
+        parallel_for(mx._factory.pool(), 0, mx.rows(),
+                     elementwise_grain(mx.columns()),
+                     [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; i++) {
+                elementwise_scale(mx.columns(), scalar, dense->row(i),
+                                  scaled->row(i));
+            }
+        });
+        Matrix result(std::move(scaled), mx._factory);
+        result.optimize();
+        return result;
+    }
+    Matrix result = mx.mutable_copy();
+    auto & repr = result.mutable_repr();
+    mx.for_each_nonzero(
+        [&repr, scalar](std::size_t row, std::size_t column, double val) {
+            repr.modify(row, column, val * scalar);
+        });
+    result.optimize();
+    return result;
+}
+
+Matrix Matrix::linear_combination(
+    const std::vector<std::pair<double, Matrix>> & terms) {
+    if (terms.empty()) {
+        throw std::invalid_argument("Linear combination: no terms.");
+    }
+    const Matrix & first = terms.front().second;
+    std::size_t rows = first.rows();
+    std::size_t columns = first.columns();
+
+    // merge terms sharing a representation, eg. A + 2 * A
+    std::vector<std::pair<double, const MatrixMemoryRepr *>> merged;
+    for (const auto & [coefficient, matrix] : terms) {
+        if (matrix.rows() != rows || matrix.columns() != columns) {
+            throw std::invalid_argument(
+                "Linear combination: dimensions are not matching.");
+        }
+        auto same = std::find_if(merged.begin(), merged.end(),
+                                 [&matrix](const auto & term) {
+                                     return term.second == matrix._matrix.get();
+                                 });
+        if (same != merged.end()) {
+            same->first += coefficient;
+        } else {
+            merged.emplace_back(coefficient, matrix._matrix.get());
+        }
+    }
+    if (merged.size() == 1 && merged.front().first == 1) {
+        return first;
+    }
+
+    std::vector<std::pair<double, const DenseMatrix *>> dense_terms;
+    std::vector<std::pair<double, const MatrixMemoryRepr *>> other_terms;
+    for (const auto & [coefficient, repr] : merged) {
+        if (auto dense = dynamic_cast<const DenseMatrix *>(repr)) {
+            dense_terms.emplace_back(coefficient, dense);
+        } else {
+            other_terms.emplace_back(coefficient, repr);
+        }
+    }
+
+    if (dense_terms.empty()) {
+        Matrix result(rows, columns, first._factory);
+        auto & repr = result.mutable_repr();
+        for (const auto & [coefficient, term] : other_terms) {
+            ::for_each_nonzero(*term, [&, coefficient = coefficient](
+                                          std::size_t row, std::size_t column,
+                                          double val) {
+                repr.add(row, column, coefficient * val);
+            });
+        }
+        result.optimize();
+        return result;
+    }
+
+    auto combined = std::make_unique<DenseMatrix>(rows, columns);
+    parallel_for(first._factory.pool(), 0, rows, elementwise_grain(columns),
+                 [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            double * out = combined->row(i);
+            elementwise_scale(columns, dense_terms.front().first,
+                              dense_terms.front().second->row(i), out);
+            for (std::size_t t = 1; t < dense_terms.size(); t++) {
+                elementwise_add(columns, out, dense_terms[t].first,
+                                dense_terms[t].second->row(i), out);
+            }
+        }
+    });
+    for (const auto & [coefficient, term] : other_terms) {
+        ::for_each_nonzero(*term, [&, coefficient = coefficient](
+                                      std::size_t row, std::size_t column,
+                                      double val) {
+            combined->row(row)[column] += coefficient * val;
+        });
     }
+    Matrix result(std::move(combined), first._factory);
     result.optimize();
     return result;
 }
 
 std::size_t Matrix::rows() const { return _matrix->rows(); }
 
+std::size_t Matrix::nnz() const { return _matrix->nnz(); }
+
 std::size_t Matrix::columns() const { return _matrix->columns(); }
 
 IteratorWrapper Matrix::begin() const { return _matrix->begin(); }
@@ -176,25 +380,85 @@ IteratorWrapper Matrix::begin() const { return _matrix->begin(); }
 IteratorWrapper Matrix::end() const { return _matrix->end(); }
 
 Matrix Matrix::transpose() const {
-    Matrix transposed(columns(), rows(), _factory);
-    for (const auto & [pos, val] : *this) {
-        transposed._matrix->modify(pos.column, pos.row, val);
+    if (auto dense = dynamic_cast<const DenseMatrix *>(_matrix.get())) {
+        auto transposed = std::make_unique<DenseMatrix>(columns(), rows());
+        // rows of the result are written in tiles, so the read columns
+        // stay in cache
+        parallel_for(_factory.pool(), 0, columns(), TRANSPOSE_TILE,
+                     [&](std::size_t first, std::size_t last) {
+            for (std::size_t i0 = 0; i0 < rows(); i0 += TRANSPOSE_TILE) {
+                std::size_t i1 = std::min(rows(), i0 + TRANSPOSE_TILE);
+                for (std::size_t j = first; j < last; j++) {
+                    double * out = transposed->row(j);
+                    for (std::size_t i = i0; i < i1; i++) {
+                        out[i] = dense->row(i)[j];
+                    }
+                }
+            }
+        });
+        return Matrix(std::move(transposed), _factory);
     }
+    if (auto compressed =
+            dynamic_cast<const CompressedSparseMatrix *>(_matrix.get())) {
+        // the column view of a matrix is the row storage of its transpose
+        const auto & view = compressed->csc();
+        return Matrix(std::make_unique<CompressedSparseMatrix>(
+                          columns(), rows(),
+                          std::vector<std::size_t>(view.column_offsets),
+                          std::vector<std::size_t>(view.row_indices),
+                          std::vector<double>(view.values)),
+                      _factory);
+    }
+    std::unique_ptr<MatrixMemoryRepr> repr(
+        _factory.get_initial_repr(columns(), rows(), nnz(), true));
+    for_each_nonzero([&repr](std::size_t row, std::size_t column, double val) {
+        repr->modify(column, row, val);
+    });
+    Matrix transposed(std::move(repr), _factory);
+    transposed.optimize();
     return transposed;
 }
 
+// copies src into the rows of dst starting at first_row
+static void copy_rows(const MatrixMemoryRepr & src, DenseMatrix & dst,
+                      std::size_t first_row) {
+    if (auto dense = dynamic_cast<const DenseMatrix *>(&src)) {
+        for (std::size_t i = 0; i < src.rows(); i++) {
+            std::copy(dense->row(i), dense->row(i) + src.columns(),
+                      dst.row(first_row + i));
+        }
+        return;
+    }
+    for_each_nonzero(src, [&](std::size_t row, std::size_t column,
+                              double val) {
+        dst.row(first_row + row)[column] = val;
+    });
+}
+
 Matrix Matrix::unite(const Matrix & first, const Matrix & second) {
     if (first.columns() != second.columns()) {
         throw std::invalid_argument("Unite: matrix dimension mismatch");
     }
-    Matrix united(first.rows() + second.rows(), first.columns(),
-                  first._factory);
-    for (const auto & [pos, val] : first) {
-        united._matrix->modify(pos.row, pos.column, val);
-    }
-    for (const auto & [pos, val] : second) {
-        united._matrix->modify(pos.row + first.rows(), pos.column, val);
+    bool from_sparse = !dynamic_cast<const DenseMatrix *>(first._matrix.get()) &&
+                       !dynamic_cast<const DenseMatrix *>(second._matrix.get());
+    std::unique_ptr<MatrixMemoryRepr> repr(first._factory.get_initial_repr(
+        first.rows() + second.rows(), first.columns(),
+        first.nnz() + second.nnz(), from_sparse));
+    if (auto dense = dynamic_cast<DenseMatrix *>(repr.get())) {
+        copy_rows(*first._matrix, *dense, 0);
+        copy_rows(*second._matrix, *dense, first.rows());
+    } else {
+        first.for_each_nonzero(
+            [&repr](std::size_t row, std::size_t column, double val) {
+                repr->modify(row, column, val);
+            });
+        second.for_each_nonzero([&repr, offset = first.rows()](
+                                    std::size_t row, std::size_t column,
+                                    double val) {
+            repr->modify(row + offset, column, val);
+        });
     }
+    Matrix united(std::move(repr), first._factory);
     united.optimize();
     return united;
 }
@@ -209,13 +473,28 @@ Matrix Matrix::cut(std::size_t new_size_rows, std::size_t new_size_columns,
         throw std::invalid_argument("Cut: invalid new dimensions or offset.");
     }
 
-    Matrix result(new_size_rows, new_size_columns, _factory);
-    for (std::size_t i = 0; i < new_size_rows; i++) {
-        for (std::size_t j = 0; j < new_size_columns; j++) {
-            result._matrix->modify(
-                i, j, _matrix->at(offset_rows + i, offset_columns + j).value());
+    // non-zeroes are expected to be spread evenly over the matrix
+    std::size_t expected_nnz = double(nnz()) * new_size_rows *
+                               new_size_columns / (rows() * columns());
+    auto dense = dynamic_cast<const DenseMatrix *>(_matrix.get());
+    std::unique_ptr<MatrixMemoryRepr> repr(_factory.get_initial_repr(
+        new_size_rows, new_size_columns, expected_nnz, !dense));
+    auto dense_result = dynamic_cast<DenseMatrix *>(repr.get());
+    if (dense && dense_result) {
+        for (std::size_t i = 0; i < new_size_rows; i++) {
+            const double * src = dense->row(offset_rows + i) + offset_columns;
+            std::copy(src, src + new_size_columns, dense_result->row(i));
         }
+    } else {
+        for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+            if (row >= offset_rows && row < offset_rows + new_size_rows &&
+                column >= offset_columns &&
+                column < offset_columns + new_size_columns) {
+                repr->modify(row - offset_rows, column - offset_columns, val);
+            }
+        });
     }
+    Matrix result(std::move(repr), _factory);
     result.optimize();
     return result;
 }
@@ -243,125 +522,80 @@ Matrix Matrix::cut(const Matrix & new_size_rows_mx,
     return cut(new_size_rows, new_size_column, offset_rows, offset_columns);
 }
 
-// https://www.researchgate.net/publication/220337322_An_Efficient_and_Simple_Algorithm_for_Matrix_Inversion
-// implementing this algorithm shortened my expected lifespan by like 5 years
-// the algorithm is described in mathematical notation and in C, however,
-// the order of steps between these descriptions doesn't match up, the
-// mathematical notation is simply wrong. if you ever decide to reimplement this
-// (please don't), then don't bother with the math notation and rewrite the
-// C code provided in the link (because it's wrong as well lmao, it doesn't
-// make any sense)
-Matrix Matrix::inverse() const {
-    if (rows() != columns()) {
-        throw std::logic_error("Non-square matrices cannot be inverted.");
+FactorizationCache & Matrix::cache() const {
+    if (!_cache) {
+        _cache = std::make_shared<FactorizationCache>();
     }
+    return *_cache;
+}
 
-    Matrix result(*this);
-
-    std::queue<std::size_t> index_queue;
-    std::set<std::size_t> visited_indexes;
-    std::size_t dim = rows();
+std::shared_ptr<FactorizationCache> Matrix::shared_cache() const {
+    cache();
+    return _cache;
+}
 
-    for (std::size_t i = 0; i < dim; i++) {
-        index_queue.emplace(i);
+std::shared_ptr<const LUDecomposition>
+Matrix::decompose(LUDecomposition::Pivoting pivoting) const {
+    auto & cached = pivoting == LUDecomposition::Pivoting::EXACT
+                        ? cache().lu
+                        : cache().echelon;
+    if (cached) {
+        return cached;
     }
-
-    std::vector<std::pair<std::size_t, std::size_t>> row_swap_vec;
-    result.gem_swap_rows(
-        [&](std::size_t i, std::size_t j) { row_swap_vec.emplace_back(i, j); });
-
-    for (std::size_t pivot_loc = index_queue.front(); !index_queue.empty();
-         index_queue.pop(), pivot_loc = index_queue.front()) {
-        double pivot = result._matrix->at(pivot_loc, pivot_loc).value();
-        if (pivot == 0) {
-            if (!visited_indexes.count(pivot_loc)) {
-                index_queue.emplace(pivot_loc);
-                visited_indexes.emplace(pivot_loc);
-                continue;
-            }
-            throw std::runtime_error("Matrix is not invertible.");
-        }
-        // step 6
-        for (std::size_t pivot_column = 0; pivot_column < dim; pivot_column++) {
-            result._matrix->modify(
-                pivot_column, pivot_loc,
-                result._matrix->at(pivot_column, pivot_loc).value() / (-pivot));
-        }
-        // step 7
-        for (std::size_t j = 0; j < dim; j++) {
-            if (pivot_loc != j) {
-                for (std::size_t k = 0; k < dim; k++) {
-                    if (pivot_loc != k) {
-                        result._matrix->add(
-                            j, k,
-                            result._matrix->at(pivot_loc, k).value() *
-                                result._matrix->at(j, pivot_loc).value());
-                    }
-                }
-            }
-        }
-        // step 5 / 8
-        for (std::size_t pivot_row = 0; pivot_row < dim; pivot_row++) {
-            result._matrix->modify(
-                pivot_loc, pivot_row,
-                result._matrix->at(pivot_loc, pivot_row).value() / pivot);
-        }
-        result._matrix->modify(pivot_loc, pivot_loc,
-                               1 / pivot); // step 8 / 9
+    auto lu = std::make_shared<const LUDecomposition>(*_matrix, pivoting,
+                                                      _factory.pool());
+    // a decomposition of a sparse matrix may be much larger than the matrix
+    if (dynamic_cast<const DenseMatrix *>(_matrix.get())) {
+        cached = lu;
     }
+    return lu;
+}
 
-    for (const auto & [first_row, second_row] : row_swap_vec) {
-        result._matrix->swap_rows(first_row, second_row);
+// nothing else is derived from the exact decomposition
+static void release_exact_lu(FactorizationCache & cache) {
+    if (cache.det && cache.inverse) {
+        cache.lu.reset();
     }
+}
 
-    result.optimize();
-    return result;
+Matrix Matrix::inverse() const {
+    if (rows() != columns()) {
+        throw std::logic_error("Non-square matrices cannot be inverted.");
+    }
+    FactorizationCache & factorization = cache();
+    if (!factorization.inverse) {
+        Matrix result(
+            std::make_unique<DenseMatrix>(
+                decompose(LUDecomposition::Pivoting::EXACT)->inverse()),
+            _factory);
+        result.optimize();
+        factorization.inverse =
+            std::make_shared<const Matrix>(std::move(result));
+        release_exact_lu(factorization);
+    }
+    return *factorization.inverse;
 }
 
 std::optional<double> Matrix::det() const {
     if (rows() != columns()) {
         return std::nullopt;
     }
-    Matrix copied_matrix(*this);
-
-    std::vector<double> division_vec;
-    copied_matrix.gem_swap_rows(
-        [&](std::size_t, std::size_t) { division_vec.emplace_back(-1); });
-
-    copied_matrix.gem_row_elim([&](std::size_t i, std::size_t) {
-        division_vec.emplace_back(copied_matrix._matrix->at(i, i).value());
-    });
-
-    double det = 1;
-    for (std::size_t i = 0; i < rows(); i++) {
-        det *= copied_matrix._matrix->at(i, i).value();
-    }
-
-    for (const auto & i : division_vec) {
-        if (i == 0) {
-            return 0;
-        }
-        det /= i;
+    FactorizationCache & factorization = cache();
+    if (!factorization.det) {
+        factorization.det =
+            decompose(LUDecomposition::Pivoting::EXACT)->det();
+        release_exact_lu(factorization);
     }
-
-    return det;
+    return factorization.det;
 }
 
 std::size_t Matrix::rank() const {
-    Matrix copied_matrix(*this);
-    copied_matrix.gem();
-
-    std::size_t rank = 0;
-    for (std::size_t i = 0; i < rows(); i++) {
-        for (std::size_t j = 0; j < columns(); j++) {
-            if (copied_matrix._matrix->at(i, j).value() != 0) {
-                rank++;
-                break;
-            }
-        }
+    FactorizationCache & factorization = cache();
+    if (!factorization.rank) {
+        factorization.rank =
+            decompose(LUDecomposition::Pivoting::RANK_REVEALING)->rank();
     }
-
-    return rank;
+    return *factorization.rank;
 }
 
 std::ostream & operator<<(std::ostream & os, const Matrix & mx) {
@@ -370,9 +604,10 @@ std::ostream & operator<<(std::ostream & os, const Matrix & mx) {
 }
 
 Matrix Matrix::gem() const {
-    Matrix result(*this);
-    result.gem_swap_rows();
-    result.gem_row_elim();
+    Matrix result(
+        std::make_unique<DenseMatrix>(
+            decompose(LUDecomposition::Pivoting::RANK_REVEALING)->upper()),
+        _factory);
     result.optimize();
     return result;
-}
\ No newline at end of file
+}
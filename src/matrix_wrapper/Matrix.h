@@ -1,9 +1,11 @@
 #pragma once
 
 #include "../iterators/IteratorWrapper.h"
+#include "../representations/ForEachNonzero.h"
 #include "../representations/MatrixMemoryRepr.h"
+#include "FactorizationCache.h"
+#include "LUDecomposition.h"
 #include "MatrixFactory.h"
-#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <memory>
@@ -13,7 +15,9 @@
 /**
  * @brief Matrix is a wrapper around MatrixMemoryRepr, which implements
  *        automatic transitions between representations and implements
- * algorithms common for matrices.
+ * algorithms common for matrices. Multiplication, element-wise operations and
+ * the LU decomposition of large matrices are split into blocks of rows and
+ * run on the thread pool of the factory, see <b>MatrixFactory::pool</b>.
  */
 class Matrix {
   public:
@@ -46,14 +50,47 @@ class Matrix {
     Matrix(const MatrixMemoryRepr & representation, MatrixFactory factory);
 
     /**
-     * @brief Constructs a matrix with the appropriate representation from the
-     *        given range. Dimensions are automatically detected.
-     * @param begin Start of the given range.
-     * @param end End of the given range.
+     * @brief Constructs a matrix from a row-major buffer without copying
+     *        it, see <b>MatrixFactory::get_initial_repr(rows, columns,
+     *        data)</b>.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param data Buffer with rows <b>DenseMatrix::stride_for(columns)</b>
+     *             elements apart.
      * @param factory Factory used for the creation of the appropriate
      *                representation.
      */
-    Matrix(IteratorWrapper begin, IteratorWrapper end, MatrixFactory factory);
+    Matrix(std::size_t rows, std::size_t columns, DenseMatrix::Buffer && data,
+           MatrixFactory factory);
+
+    /**
+     * @brief Constructs a matrix from its non-zero elements in any order, see
+     *        <b>MatrixFactory::get_initial_repr(rows, columns, elements)</b>.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param elements Non-zero elements of the matrix.
+     * @param factory Factory used for the creation of the appropriate
+     *                representation.
+     */
+    Matrix(std::size_t rows, std::size_t columns,
+           std::vector<MatrixElement> && elements, MatrixFactory factory);
+
+    /**
+     * @brief Constructs a matrix from compressed sparse rows without copying
+     *        them, see <b>MatrixFactory::get_initial_repr(rows, columns,
+     *        row_offsets, column_indices, values)</b>.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param row_offsets Offsets of the rows, <b>rows + 1</b> elements.
+     * @param column_indices Columns of the stored elements.
+     * @param values Values of the stored elements.
+     * @param factory Factory used for the creation of the appropriate
+     *                representation.
+     */
+    Matrix(std::size_t rows, std::size_t columns,
+           std::vector<std::size_t> && row_offsets,
+           std::vector<std::size_t> && column_indices,
+           std::vector<double> && values, MatrixFactory factory);
 
     /**
      * @brief Wraps a value in a 1x1 sparse matrix.
@@ -62,7 +99,10 @@ class Matrix {
     Matrix(double value);
 
     /**
-     * @brief Creates a deep copy of the provided matrix.
+     * @brief Creates a copy of the provided matrix in constant time. The copy
+     *        shares the representation and the factorization cache with
+     *        <b>src</b>, the representation is deeply copied only once one of
+     *        the matrices is modified.
      * @param src Matrix to be copied.
      */
     Matrix(const Matrix & src);
@@ -74,8 +114,10 @@ class Matrix {
     Matrix(Matrix && src) noexcept;
 
     /**
-     * @brief Creates a deep copy of the provided matrix and assigns it to
-     *        <b>this</b>
+     * @brief Assigns a copy of the provided matrix to <b>this</b> in
+     *        constant time, sharing the representation as described in the
+     *        copy constructor. The factorization cache of <b>this</b> is
+     *        replaced by the one of <b>src</b>.
      * @param src Matrix to be copied.
      * @return <b>*this</b>
      */
@@ -91,7 +133,8 @@ class Matrix {
 
     /**
      * @brief Implements matrix addition. Elements at the same position are
-     *        added, the result is stored in a new matrix.
+     *        added, the result is stored in a new matrix. Two dense matrices
+     *        are added by the vectorized <b>elementwise_add</b> kernel.
      * @param rhs Matrix to be added to <b>this</b>.
      * @return The resulting matrix from matrix addition.
      * @throws std::invalid_argument if <b>this</b> and <b>rhs</b> don't have
@@ -101,7 +144,9 @@ class Matrix {
 
     /**
      * @brief Implements matrix subtractions. Elements at the same position are
-     *        subtracted, the result is stored in a new matrix.
+     *        subtracted, the result is stored in a new matrix. Two dense
+     *        matrices are subtracted by the vectorized <b>elementwise_add</b>
+     *        kernel.
      * @param rhs Matrix to be subtracted from <b>this</b>.
      * @return The resulting matrix from matrix subtraction.
      * @throws std::invalid_argument if <b>this</b> and <b>rhs</b> don't have
@@ -111,24 +156,47 @@ class Matrix {
 
     /**
      * @brief Implements matrix multiplication. Calls the scalar multiplication
-     *        method if <b>this</b> or <b>rhs</b> have 1x1 dimensions.
+     *        method if <b>this</b> or <b>rhs</b> have 1x1 dimensions. The
+     *        product is computed by a kernel picked by the representations of
+     *        both operands: <b>dense_gemm</b> for two dense matrices,
+     *        <b>sparse_gemm</b> for two sparse ones and
+     *        <b>sparse_dense_gemm</b> or <b>dense_sparse_gemm</b> otherwise.
      * @param rhs Matrix to multiply <b>this</b> from the right.
      * @return Product of the matrix multiplication.
      * @throws std::invalid_argument if matrix multiplication is undefined for
      *                               matrices with the given dimensions, ie.
      *                               if <b>this.columns</b> != <b>rhs.rows</b>
+     * @throws std::logic_error if an operand has a representation, which no
+     *                          kernel accepts.
      */
     Matrix operator*(const Matrix & rhs) const;
 
     /**
      * @brief Implements scalar multiplication. Every element of <b>rhs</b> gets
-     *        multiplied by <b>value</b>.
+     *        multiplied by <b>value</b>. Dense matrices are scaled by the
+     *        vectorized <b>elementwise_scale</b> kernel.
      * @param value Value to multiply the matrix by.
      * @param rhs Matrix to be multiplied by <b>value</b>
      * @return
      */
     friend Matrix operator*(double value, const Matrix & rhs);
 
+    /**
+     * @brief Evaluates <b>c_1 * M_1 + c_2 * M_2 + ...</b> in a single pass.
+     *        Terms sharing the same representation are merged first. Dense
+     *        terms are combined row by row by the vectorized element-wise
+     *        kernels, so every row of the result is written once, the
+     *        non-zero elements of other terms are added afterwards. See
+     *        <b>LinearCombination</b>.
+     * @param terms Coefficients and matrices of the combination, all of the
+     *              same dimensions. Must not be empty.
+     * @return The resulting matrix.
+     * @throws std::invalid_argument if <b>terms</b> is empty or if the
+     *                               dimensions of the matrices don't match.
+     */
+    static Matrix
+    linear_combination(const std::vector<std::pair<double, Matrix>> & terms);
+
     /**
      * @brief Creates an iterator pointing to the first element of the matrix
      *        (element at position 0,0). See <b>struct Position</b> for more
@@ -145,6 +213,17 @@ class Matrix {
      */
     IteratorWrapper end() const;
 
+    /**
+     * @brief Calls <b>visit(row, column, value)</b> for every non-zero
+     *        element of the matrix in row-major order. Prefer this over
+     *        <b>begin()</b> and <b>end()</b> in loops over whole matrices, as
+     *        it doesn't allocate or make virtual calls per element.
+     * @param visit Callable invoked for every non-zero element.
+     */
+    template <typename Visitor> void for_each_nonzero(Visitor && visit) const {
+        ::for_each_nonzero(*_matrix, visit);
+    }
+
     /**
      * @brief Getter for the number of rows of the matrix.
      * @return Number of rows of the matrix.
@@ -157,6 +236,13 @@ class Matrix {
      */
     std::size_t columns() const;
 
+    /**
+     * @brief Getter for the number of non-zero elements of the matrix.
+     *        Doesn't scan the matrix, see <b>MatrixMemoryRepr::nnz</b>.
+     * @return Number of non-zero elements of the matrix.
+     */
+    std::size_t nnz() const;
+
     /**
      * @brief Creates a transposed matrix from <b>this</b>. Additional memory
      *        for copies of the matrix may be needed.
@@ -212,7 +298,10 @@ class Matrix {
                const Matrix & offset_columns_mx) const;
 
     /**
-     * @brief Creates an inverse matrix to <b>this</b>, if it exists.
+     * @brief Creates an inverse matrix to <b>this</b>, if it exists. The
+     *        inverse is computed from the LU decomposition by forward and
+     *        backward substitution. The inverse is cached, see
+     *        <b>FactorizationCache</b>.
      * @return An inverse matrix to <b>this</b>
      * @throws std::logic_error if <b>this</b> is not a square matrix.
      * @throws std::runtime_error if an inverse matrix to <b>this</b>
@@ -221,20 +310,24 @@ class Matrix {
     Matrix inverse() const;
 
     /**
-     * @brief Calculates the determinant of <b>this</b>.
+     * @brief Calculates the determinant of <b>this</b> as the signed product
+     *        of the diagonal of <b>U</b> from the LU decomposition. The
+     *        determinant is cached.
      * @return std::nullopt if <b>this</b> isn't a square matrix, the
      * determinant of <b>this</b> otherwise.
      */
     std::optional<double> det() const;
 
     /**
-     * @brief Calculates the rank of <b>this</b>.
+     * @brief Calculates the rank of <b>this</b> as the number of pivots of
+     *        the LU decomposition. The rank is cached.
      * @return Rank of the matrix.
      */
     std::size_t rank() const;
 
     /**
-     * @brief Implements Gaussian elimination to row echelon form.
+     * @brief Implements Gaussian elimination with partial pivoting to row
+     *        echelon form, ie. returns <b>U</b> of the LU decomposition.
      * @return The matrix eliminated into row echelon form.
      */
     Matrix gem() const;
@@ -250,9 +343,10 @@ class Matrix {
   private:
     /**
      * @brief A pointer to a memory representation of the given matrix. Utilises
-     *        polymorphism.
+     *        polymorphism. The representation is shared by copies of the
+     *        matrix and copied on write, see <b>mutable_repr</b>.
      */
-    std::unique_ptr<MatrixMemoryRepr> _matrix;
+    std::shared_ptr<MatrixMemoryRepr> _matrix;
 
     /**
      * @brief A matrix factory used for retrieving representations in
@@ -262,46 +356,65 @@ class Matrix {
     MatrixFactory _factory;
 
     /**
-     * @brief A helper function for Gaussian elimination, matrix inversion
-     *        and determinant calculation. Swaps rows as necessary to convert
-     *        the matrix to row echelon form.
-     * @param capture_fn A function which serves to optimise different use cases
-     *                   for row-swapping. Is called everytime 2 rows are
-     * swapped with the indices of the two swapped rows. Defaults to an empty
-     * lambda function if not provided.
+     * @brief Lazily computed factorization and values derived from it.
+     *        Shared by copies of the matrix, see <b>FactorizationCache</b>.
+     *        Created on the first use or copy, so that results computed on
+     *        a copy fill the cache of the original, dropped whenever the
+     *        matrix is modified.
      */
-    void gem_swap_rows(
-        std::function<void(std::size_t row1, std::size_t row2)> && capture_fn =
-            default_capture);
+    mutable std::shared_ptr<FactorizationCache> _cache;
 
     /**
-     * @brief A helper function for Gaussian elimination and determinant
-     *        calculation. Eliminates rows as necessary to allow conversion
-     *        of the matrix to row echelon form.
-     * @param capture_fn A function used for optimising memory requirements
-     *                   when using this function across different methods.
-     *                   This function is called everytime a top row is
-     *                   subtracted from a row below it. Row and column are
-     *                   indices to the first non-zero element in the top row.
-     *                   Defaults to an empty lambda when no function is
-     *                   provided.
+     * @brief Getter for the factorization cache, creates it if needed.
+     * @return The cache of <b>this</b>.
      */
-    void gem_row_elim(
-        std::function<void(std::size_t row, std::size_t column)> && capture_fn =
-            default_capture);
+    FactorizationCache & cache() const;
 
     /**
-     * @brief A default capture lambda for <b>Matrix::gem_swap_rows</b> and
-     *        <b>Matrix::gem_row_elim</b>, for when no capture is needed.
-     *        Does nothing.
+     * @brief Getter for the factorization cache to be shared with a copy,
+     *        creates it if needed.
+     * @return The cache of <b>this</b>.
      */
-    static constexpr auto default_capture = [](std::size_t, std::size_t) {
-        return;
-    };
+    std::shared_ptr<FactorizationCache> shared_cache() const;
+
+    /**
+     * @brief Factorizes the matrix, see <b>LUDecomposition</b>. The
+     *        decomposition of a dense matrix is cached, other ones are
+     *        computed on every call.
+     * @param pivoting Decides, which pivots are usable.
+     * @return The LU decomposition of <b>this</b>.
+     */
+    std::shared_ptr<const LUDecomposition>
+    decompose(LUDecomposition::Pivoting pivoting) const;
 
     /**
      * @brief Tries to convert the representation, does nothing no optimisation
      *        can be made. Calls MatrixFactory::convert() method.
      */
     void optimize();
+
+    /**
+     * @brief Wraps the provided representation without copying it.
+     * @param representation Representation to take ownership of.
+     * @param factory Factory used for potential optimisations.
+     */
+    Matrix(std::unique_ptr<MatrixMemoryRepr> representation,
+           MatrixFactory factory);
+
+    /**
+     * @brief Returns the representation for modification. The representation
+     *        is cloned first if it's shared with another matrix, and the
+     *        factorization cache is reset. The reference is only valid until
+     *        <b>this</b> is copied, so it shouldn't be held across copies.
+     * @return A reference to the representation owned solely by <b>this</b>.
+     */
+    MatrixMemoryRepr & mutable_repr();
+
+    /**
+     * @brief Creates a deep copy of <b>this</b> in a representation suitable
+     *        for incremental modification. See
+     *        <b>MatrixFactory::get_mutable_repr</b>.
+     * @return A copy of <b>this</b>.
+     */
+    Matrix mutable_copy() const;
 };
\ No newline at end of file
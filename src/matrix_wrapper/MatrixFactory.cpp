@@ -1,40 +1,45 @@
 #include "MatrixFactory.h"
+#include "../representations/CompressedSparseMatrix.h"
 #include "../representations/DenseMatrix.h"
+#include "../representations/ForEachNonzero.h"
 #include "../representations/SparseMatrix.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
-MatrixFactory::MatrixFactory(double ratio) : _ratio(ratio) {}
+MatrixFactory::MatrixFactory(double ratio, ThreadPool * pool)
+    : _policy(ratio), _pool(pool) {}
+
+MatrixFactory::MatrixFactory(ConversionPolicy policy, ThreadPool * pool)
+    : _policy(policy), _pool(pool) {}
 
 MatrixMemoryRepr * MatrixFactory::get_initial_repr(std::size_t rows,
                                                    std::size_t columns) const {
     return new SparseMatrix(rows, columns);
 }
 
-template <typename T> bool is_sparse(const T & mx, double ratio) {
-    std::size_t rows = mx.size();
-    std::size_t columns = rows ? mx.begin()->size() : 0;
-    double zeroes_to_be_sparse = rows * columns * ratio;
-
-    std::size_t zero_count = 0;
-    for (const auto & row : mx) {
-        for (const auto & val : row) {
-            if (val == 0) {
-                ++zero_count;
-            }
-            if (zero_count >= zeroes_to_be_sparse) {
-                return true;
-            }
-        }
+MatrixMemoryRepr * MatrixFactory::get_initial_repr(std::size_t rows,
+                                                   std::size_t columns,
+                                                   std::size_t expected_nnz,
+                                                   bool from_sparse) const {
+    if (_policy.prefers_sparse(expected_nnz, rows, columns, from_sparse)) {
+        return new SparseMatrix(rows, columns);
     }
-    return false;
+    return new DenseMatrix(rows, columns);
 }
 
 MatrixMemoryRepr * MatrixFactory::get_initial_repr(
     std::initializer_list<std::initializer_list<double>> initializer) const {
-    bool matrix_is_sparse = is_sparse(initializer, _ratio);
+    std::size_t rows = initializer.size();
+    std::size_t columns = rows ? initializer.begin()->size() : 0;
+    std::size_t nnz = 0;
+    for (const auto & row : initializer) {
+        nnz += row.size() - std::count(row.begin(), row.end(), 0.0);
+    }
 
-    if (matrix_is_sparse) {
-        return new SparseMatrix(initializer);
+    if (_policy.prefers_sparse(nnz, rows, columns, false)) {
+        return new CompressedSparseMatrix(initializer);
     }
     return new DenseMatrix(initializer);
 }
@@ -45,27 +50,142 @@ MatrixMemoryRepr * MatrixFactory::get_initial_repr(double val) const {
     return repr;
 }
 
-MatrixMemoryRepr * MatrixFactory::get_initial_repr(IteratorWrapper begin,
-                                                   IteratorWrapper end) const {
-    std::size_t distance = begin.distance(end);
-    std::size_t number_of_non_zeroes = (1 - _ratio) * begin.get_matrix_rows() * begin.get_matrix_columns();
+// conversions between representations, which skip the iterator protocol
+static MatrixMemoryRepr * to_dense(const MatrixMemoryRepr & mx) {
+    auto result = new DenseMatrix(mx.rows(), mx.columns());
+    for_each_nonzero(mx, [result](std::size_t row, std::size_t column,
+                                  double val) {
+        result->row(row)[column] = val;
+    });
+    result->recount_nonzeros();
+    return result;
+}
 
-    if (distance < number_of_non_zeroes){
-        return new SparseMatrix(std::move(begin), std::move(end));
+static MatrixMemoryRepr * to_compressed(const MatrixMemoryRepr & mx) {
+    std::vector<std::size_t> row_offsets(mx.rows() + 1, 0);
+    std::vector<std::size_t> column_indices;
+    std::vector<double> values;
+    for_each_nonzero(mx, [&](std::size_t row, std::size_t column, double val) {
+        ++row_offsets[row + 1];
+        column_indices.push_back(column);
+        values.push_back(val);
+    });
+    for (std::size_t i = 0; i < mx.rows(); i++) {
+        row_offsets[i + 1] += row_offsets[i];
     }
-    return new DenseMatrix(std::move(begin), std::move(end));
+    return new CompressedSparseMatrix(mx.rows(), mx.columns(),
+                                      std::move(row_offsets),
+                                      std::move(column_indices),
+                                      std::move(values));
+}
+
+static MatrixMemoryRepr * to_sparse(const MatrixMemoryRepr & mx) {
+    auto result = new SparseMatrix(mx.rows(), mx.columns());
+    for_each_nonzero(mx, [result](std::size_t row, std::size_t column,
+                                  double val) {
+        result->modify(row, column, val);
+    });
+    return result;
+}
+
+MatrixMemoryRepr *
+MatrixFactory::get_initial_repr(std::size_t rows, std::size_t columns,
+                                DenseMatrix::Buffer && data) const {
+    auto dense = std::make_unique<DenseMatrix>(rows, columns, std::move(data));
+    if (_policy.prefers_sparse(dense->nnz(), rows, columns, false)) {
+        return to_compressed(*dense);
+    }
+    return dense.release();
+}
+
+MatrixMemoryRepr *
+MatrixFactory::get_initial_repr(std::size_t rows, std::size_t columns,
+                                std::vector<MatrixElement> && elements) const {
+    if (!rows || !columns) {
+        throw std::invalid_argument("Invalid matrix dimensions.");
+    }
+    std::stable_sort(elements.begin(), elements.end(),
+                     [](const MatrixElement & lhs, const MatrixElement & rhs) {
+                         return lhs.position < rhs.position;
+                     });
+    // keep the last of the elements sharing a position, drop zeroes
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < elements.size(); i++) {
+        const auto & [pos, val] = elements[i];
+        if (pos.row >= rows || pos.column >= columns) {
+            throw std::invalid_argument("Element out of matrix bounds.");
+        }
+        bool is_last = i + 1 == elements.size() ||
+                       pos < elements[i + 1].position;
+        if (is_last && val != 0) {
+            elements[kept++] = elements[i];
+        }
+    }
+    elements.erase(elements.begin() + kept, elements.end());
+
+    if (!_policy.prefers_sparse(elements.size(), rows, columns, false)) {
+        auto result = new DenseMatrix(rows, columns);
+        for (const auto & [pos, val] : elements) {
+            result->row(pos.row)[pos.column] = val;
+        }
+        result->recount_nonzeros();
+        return result;
+    }
+    std::vector<std::size_t> row_offsets(rows + 1, 0);
+    std::vector<std::size_t> column_indices;
+    std::vector<double> values;
+    column_indices.reserve(elements.size());
+    values.reserve(elements.size());
+    for (const auto & [pos, val] : elements) {
+        ++row_offsets[pos.row + 1];
+        column_indices.emplace_back(pos.column);
+        values.emplace_back(val);
+    }
+    for (std::size_t i = 0; i < rows; i++) {
+        row_offsets[i + 1] += row_offsets[i];
+    }
+    return new CompressedSparseMatrix(rows, columns, std::move(row_offsets),
+                                      std::move(column_indices),
+                                      std::move(values));
+}
+
+MatrixMemoryRepr *
+MatrixFactory::get_initial_repr(std::size_t rows, std::size_t columns,
+                                std::vector<std::size_t> && row_offsets,
+                                std::vector<std::size_t> && column_indices,
+                                std::vector<double> && values) const {
+    auto compressed = std::make_unique<CompressedSparseMatrix>(
+        rows, columns, std::move(row_offsets), std::move(column_indices),
+        std::move(values));
+    if (!_policy.prefers_sparse(compressed->nnz(), rows, columns, false)) {
+        return to_dense(*compressed);
+    }
+    return compressed.release();
 }
 
 MatrixMemoryRepr * MatrixFactory::convert(MatrixMemoryRepr * mx) const {
-    if (mx->is_efficient(_ratio)) {
+    bool is_dense = dynamic_cast<DenseMatrix *>(mx);
+    if (!_policy.prefers_sparse(mx->nnz(), mx->rows(), mx->columns(),
+                                !is_dense)) {
+        return is_dense ? mx : to_dense(*mx);
+    }
+    // results are mostly read from now on, compress map based matrices
+    if (dynamic_cast<CompressedSparseMatrix *>(mx)) {
         return mx;
     }
-    std::size_t non_zero_values = mx->begin().distance(mx->end());
-    std::size_t ratio_to_be_dense = (1 - _ratio) * mx->rows() * mx->columns();
-    if (non_zero_values <= ratio_to_be_dense) {
-        return new SparseMatrix(mx->begin(), mx->end());
+    return to_compressed(*mx);
+}
+
+MatrixMemoryRepr *
+MatrixFactory::get_mutable_repr(const MatrixMemoryRepr * mx) const {
+    if (dynamic_cast<const CompressedSparseMatrix *>(mx)) {
+        return to_sparse(*mx);
     }
-    return new DenseMatrix(mx->begin(), mx->end());
+    return mx->clone();
 }
 
-double MatrixFactory::ratio() const { return _ratio; }
+double MatrixFactory::ratio() const { return _policy.sparse_ratio(); }
+
+const ConversionPolicy & MatrixFactory::policy() const { return _policy; }
+
+ThreadPool * MatrixFactory::pool() const { return _pool; }
@@ -1,7 +1,10 @@
 #pragma once
 
-#include "../iterators/IteratorWrapper.h"
+#include "../parallel/ThreadPool.h"
+#include "../representations/DenseMatrix.h"
 #include "../representations/MatrixMemoryRepr.h"
+#include "MatrixElement.h"
+#include "ConversionPolicy.h"
 #include <vector>
 
 /**
@@ -18,8 +21,22 @@ class MatrixFactory {
      * @param sparse_ratio Ratio of zeroes to the non-zero elements in a matrix.
      *                     This ratio determines the final representation of the
      *                     matrix.
+     * @param pool Thread pool used by operations on matrices created with
+     *             this factory, or a nullptr to run them on the calling
+     *             thread. The pool isn't owned by the factory and has to
+     *             outlive it.
      */
-    explicit MatrixFactory(double sparse_ratio);
+    explicit MatrixFactory(double sparse_ratio, ThreadPool * pool = nullptr);
+
+    /**
+     * @brief Creates a MatrixFactory converting matrices according to the
+     *        provided policy.
+     * @param policy Policy deciding the representations of matrices.
+     * @param pool Thread pool used by operations on matrices created with
+     *             this factory, see the constructor above.
+     */
+    explicit MatrixFactory(ConversionPolicy policy,
+                           ThreadPool * pool = nullptr);
 
     /**
      * @brief Creates a representation for a zero filled of the given
@@ -36,11 +53,31 @@ class MatrixFactory {
     MatrixMemoryRepr * get_initial_repr(std::size_t rows,
                                         std::size_t columns) const;
 
+    /**
+     * @brief Creates a zero filled representation for the result of an
+     *        operation, which is expected to have the given number of
+     *        non-zero elements. A dense matrix is returned if the conversion
+     *        policy would store such a result as dense, a map based sparse
+     *        matrix otherwise, so results don't have to be converted once
+     *        they are computed. The returned pointer is dynamically
+     *        allocated, deleting it is the responsibility of the programmer.
+     * @param rows Number of desired rows in the matrix.
+     * @param columns Number of desired columns in the matrix.
+     * @param expected_nnz Expected number of non-zero elements of the result.
+     * @param from_sparse Whether the operands of the operation are sparse,
+     *                    see <b>ConversionPolicy::prefers_sparse</b>.
+     * @return A pointer to a dynamically allocated representation.
+     */
+    MatrixMemoryRepr * get_initial_repr(std::size_t rows, std::size_t columns,
+                                        std::size_t expected_nnz,
+                                        bool from_sparse) const;
+
     /**
      * @brief Creates an efficient representation for a matrix initialized with
-     *        the provided initializer_list. If the initializer list has at
-     *        least 'ratio*num_of_rows_of_init*num_of_columns_of_init' elements
-     *        equal to zero, the values will be represented in a sparse matrix,
+     *        the provided initializer_list. If the conversion policy
+     *        prefers a sparse matrix for its number of non-zero elements,
+     *        see <b>ConversionPolicy::prefers_sparse</b>, the values will be
+     *        represented in a compressed sparse matrix,
      *        or a dense matrix otherwise. The final representation is
      *        dynamically allocated, it is up to the programmer to delete it.
      * @param init An initializer list used to create the representation.
@@ -69,28 +106,72 @@ class MatrixFactory {
     MatrixMemoryRepr * get_initial_repr(double value) const;
 
     /**
-     * @brief Creates a memory effective representation of a matrix from the
-     *        range determined by the provided iterators. The resulting
-     *        representation is dynamically allocated, it's the programmer's
-     *        responsibility to delete it.
-     * @param begin An iterator determining the start of the range, from which
-     *              the representation will be constructed.
-     * @param end An iterator to the end of the given range.
-     * @return A pointer to a dynamically allocated representation of the
-     *         matrix determined by the given range.
+     * @brief Creates an efficient representation for a matrix from a
+     *        row-major buffer laid out as described in
+     *        <b>DenseMatrix(rows, columns, data)</b>. Dense matrices adopt the
+     *        buffer without copying it, sparse ones are compressed from it in
+     *        a single pass. The resulting representation is dynamically
+     *        allocated, it's the programmer's responsibility to delete it.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param data Buffer with the elements of the matrix.
+     * @return A pointer to a dynamically allocated representation.
+     * @throws std::invalid_argument if the dimensions or the size of the
+     *                               buffer are invalid.
      */
-    MatrixMemoryRepr * get_initial_repr(IteratorWrapper begin,
-                                        IteratorWrapper end) const;
+    MatrixMemoryRepr * get_initial_repr(std::size_t rows, std::size_t columns,
+                                        DenseMatrix::Buffer && data) const;
+
+    /**
+     * @brief Creates an efficient representation for a matrix from its
+     *        non-zero elements in any order. The elements are sorted in
+     *        place and written straight into the compressed or dense
+     *        storage. If a position occurs more than once, the last element
+     *        wins. The resulting representation is dynamically allocated,
+     *        it's the programmer's responsibility to delete it.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param elements Elements of the matrix, zeroes are skipped.
+     * @return A pointer to a dynamically allocated representation.
+     * @throws std::invalid_argument if the dimensions are invalid or an
+     *                               element is out of bounds.
+     */
+    MatrixMemoryRepr *
+    get_initial_repr(std::size_t rows, std::size_t columns,
+                     std::vector<MatrixElement> && elements) const;
+
+    /**
+     * @brief Creates an efficient representation for a matrix from already
+     *        compressed arrays laid out as described in
+     *        <b>CompressedSparseMatrix(rows, columns, row_offsets,
+     *        column_indices, values)</b>. Sparse matrices adopt the arrays
+     *        without copying them, dense ones are expanded from them. The
+     *        resulting representation is dynamically allocated, it's the
+     *        programmer's responsibility to delete it.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param row_offsets Offsets of the rows, <b>rows + 1</b> elements.
+     * @param column_indices Columns of the stored elements.
+     * @param values Values of the stored elements.
+     * @return A pointer to a dynamically allocated representation.
+     * @throws std::invalid_argument if the dimensions or the sizes of the
+     *                               arrays are invalid.
+     */
+    MatrixMemoryRepr *
+    get_initial_repr(std::size_t rows, std::size_t columns,
+                     std::vector<std::size_t> && row_offsets,
+                     std::vector<std::size_t> && column_indices,
+                     std::vector<double> && values) const;
 
     /**
      * @brief Converts a matrix representation to a different one, if the
-     *        current representation is inefficient given in the given ratio.
-     *        The efficiency is determined by the is_efficient(ratio)
-     *        method of the representation. May return the repr_to_convert
-     *        if no conversion is necessary. Conversion is handled by iterating
-     *        over the representation using it's begin() and end() methods.
-     *        If the representation is converted, the returned representation
-     *        is heap allocated, it's up to the programmer to delete it.
+     *        conversion policy prefers the other one, see
+     *        <b>ConversionPolicy::prefers_sparse</b>. Map based sparse
+     *        matrices are compressed, as converted matrices are mostly read
+     *        from. May return the repr_to_convert if no conversion is
+     *        necessary. If the representation is converted, the returned
+     *        representation is heap allocated, it's up to the programmer to
+     *        delete it.
      * @param repr_to_convert Pointer to the representation to convert.
      * @return repr_to_convert if no conversion is needed, a memory efficient
      *         copy of the provided representation otherwise.
@@ -98,16 +179,43 @@ class MatrixFactory {
     MatrixMemoryRepr * convert(MatrixMemoryRepr * repr_to_convert) const;
 
     /**
-     * @brief Returns the ratio provided in the constructor.
+     * @brief Creates a copy of the provided representation, which is suitable
+     *        for heavy incremental modification. Compressed sparse matrices
+     *        are copied into a map based <b>SparseMatrix</b>, other
+     *        representations are cloned. The returned representation is heap
+     *        allocated, it's up to the programmer to delete it.
+     * @param repr Representation to copy.
+     * @return A pointer to a dynamically allocated copy of <b>repr</b>.
+     */
+    MatrixMemoryRepr * get_mutable_repr(const MatrixMemoryRepr * repr) const;
+
+    /**
+     * @brief Returns the sparse ratio of the conversion policy.
      * @return Ratio used to determine efficiency of matrix representations.
      */
     double ratio() const;
 
+    /**
+     * @brief Returns the policy deciding the representations of matrices.
+     * @return The conversion policy.
+     */
+    const ConversionPolicy & policy() const;
+
+    /**
+     * @brief Returns the thread pool provided in the constructor.
+     * @return Thread pool for parallel operations, may be a nullptr.
+     */
+    ThreadPool * pool() const;
+
   private:
     /**
-     * @brief Ratio used to judge memory efficiency of representations.
-     *        A matrix is determined to be sparse, if it has at least
-     *        (1 - ratio)*rows*columns elements equal to zero.
+     * @brief Policy used to judge memory efficiency of representations.
+     */
+    ConversionPolicy _policy;
+
+    /**
+     * @brief A non-owning pointer to the thread pool shared by all matrices
+     *        created with this factory.
      */
-    double _ratio;
+    ThreadPool * _pool;
 };
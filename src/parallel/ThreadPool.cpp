@@ -0,0 +1,169 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+// the queue owned by the current thread, set for the workers of a pool
+static thread_local const ThreadPool * current_pool = nullptr;
+static thread_local std::size_t current_queue = 0;
+
+// number of blocks per thread, more blocks balance the load better
+static inline constexpr std::size_t BLOCKS_PER_THREAD = 4;
+
+ThreadPool::ThreadPool(std::size_t threads) : _pending(0), _stop(false) {
+    if (!threads) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < threads; i++) {
+        _queues.emplace_back(std::make_unique<WorkQueue>());
+    }
+    for (std::size_t i = 0; i + 1 < threads; i++) {
+        _workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(_sleep_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto & worker : _workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const { return _workers.size() + 1; }
+
+std::size_t ThreadPool::home_queue() const {
+    if (current_pool == this) {
+        return current_queue;
+    }
+    return _queues.size() - 1;
+}
+
+void ThreadPool::push(Task && task, std::size_t queue) {
+    {
+        // counted before queuing, so the counter never underflows
+        std::lock_guard<std::mutex> guard(_sleep_lock);
+        ++_pending;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_queues[queue]->lock);
+        _queues[queue]->tasks.emplace_back(std::move(task));
+    }
+    _wake.notify_one();
+}
+
+bool ThreadPool::run_one(std::size_t home) {
+    Task task;
+    for (std::size_t i = 0; i < _queues.size() && !task; i++) {
+        auto & queue = *_queues[(home + i) % _queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // own tasks are taken from the back, stolen ones from the front
+        if (!i) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    --_pending;
+    task();
+    return true;
+}
+
+void ThreadPool::work(std::size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        if (run_one(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(_sleep_lock);
+        _wake.wait(guard, [this] { return _stop || _pending > 0; });
+        if (_stop) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallel_for(
+    std::size_t begin, std::size_t end, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)> & fn) {
+    if (begin >= end) {
+        return;
+    }
+    std::size_t count = end - begin;
+    std::size_t target_blocks = size() * BLOCKS_PER_THREAD;
+    std::size_t block = std::max(
+        {grain, std::size_t(1), (count + target_blocks - 1) / target_blocks});
+    std::size_t blocks = (count + block - 1) / block;
+    if (blocks <= 1 || _workers.empty()) {
+        fn(begin, end);
+        return;
+    }
+
+    // shared with the tasks, the last task may still notify after the
+    // submitting thread has seen the counter drop to zero
+    struct State {
+        std::atomic<std::size_t> remaining;
+        std::mutex lock;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = blocks;
+
+    std::size_t home = home_queue();
+    for (std::size_t b = 0; b < blocks; b++) {
+        std::size_t block_begin = begin + b * block;
+        std::size_t block_end = std::min(end, block_begin + block);
+        push(
+            [state, &fn, block_begin, block_end] {
+                try {
+                    fn(block_begin, block_end);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(state->lock);
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                }
+                if (state->remaining.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> guard(state->lock);
+                    state->done.notify_all();
+                }
+            },
+            (home + b) % _queues.size());
+    }
+
+    while (state->remaining > 0) {
+        if (run_one(home)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(state->lock);
+        state->done.wait(guard, [&state] { return state->remaining == 0; });
+    }
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void parallel_for(ThreadPool * pool, std::size_t begin, std::size_t end,
+                  std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)> & fn) {
+    if (begin >= end) {
+        return;
+    }
+    if (!pool || end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+    pool->parallel_for(begin, end, grain, fn);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A work-stealing thread pool. Every worker owns a task queue, it
+ *        takes tasks from the back of its own queue and steals from the
+ *        front of the queues of other workers when its own queue is empty.
+ *        The thread submitting work is counted as one of the threads of the
+ *        pool and executes tasks as well until its work is finished, so a
+ *        pool of a single thread runs everything inline.
+ */
+class ThreadPool {
+  public:
+
+    /**
+     * @brief Starts the worker threads.
+     * @param threads Total number of threads executing work, including the
+     *                thread submitting it. Zero stands for the number of
+     *                hardware threads.
+     */
+    explicit ThreadPool(std::size_t threads);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Stops and joins all workers. Tasks still waiting in the queues
+     *        are discarded.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Getter for the number of threads executing work.
+     * @return Number of workers plus the submitting thread.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Splits range [<b>begin</b>, <b>end</b>) into blocks of at least
+     *        <b>grain</b> indices and calls <b>fn</b>(block_begin, block_end)
+     *        for every block in parallel. Returns after all blocks are
+     *        processed. Blocks are disjoint, so as long as <b>fn</b> only
+     *        writes data belonging to its block, the results don't depend on
+     *        the number of threads.
+     * @param begin Start of the range.
+     * @param end End of the range.
+     * @param grain Minimal number of indices in a single block.
+     * @param fn Function processing a single block.
+     * @throws Rethrows the first exception thrown by <b>fn</b>.
+     */
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                      const std::function<void(std::size_t, std::size_t)> & fn);
+
+  private:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief A task queue of a single worker guarded by its own lock.
+     */
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     * @brief One queue per worker, the last one is used by threads outside
+     *        of the pool.
+     */
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+
+    std::vector<std::thread> _workers;
+
+    /**
+     * @brief Number of queued tasks, workers sleep while it's zero.
+     */
+    std::atomic<std::size_t> _pending;
+
+    std::mutex _sleep_lock;
+
+    std::condition_variable _wake;
+
+    bool _stop;
+
+    /**
+     * @brief Queues a task and wakes up a sleeping worker.
+     * @param task Task to queue.
+     * @param queue Index of the target queue.
+     */
+    void push(Task && task, std::size_t queue);
+
+    /**
+     * @brief Executes a single task from the queue <b>home</b>, or a task
+     *        stolen from another queue if <b>home</b> is empty.
+     * @param home Index of the queue of the calling thread.
+     * @return True if a task was executed, false if all queues were empty.
+     */
+    bool run_one(std::size_t home);
+
+    /**
+     * @brief Main loop of a worker thread.
+     * @param index Index of the worker's queue.
+     */
+    void work(std::size_t index);
+
+    /**
+     * @brief Returns the index of the queue owned by the calling thread.
+     */
+    std::size_t home_queue() const;
+};
+
+/**
+ * @brief Calls <b>pool->parallel_for</b>, or <b>fn</b>(begin, end) on the
+ *        calling thread if <b>pool</b> is a nullptr or the range doesn't
+ *        exceed a single block.
+ */
+void parallel_for(ThreadPool * pool, std::size_t begin, std::size_t end,
+                  std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)> & fn);
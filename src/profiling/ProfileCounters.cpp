@@ -0,0 +1,53 @@
+#include "ProfileCounters.h"
+#include <atomic>
+
+// relaxed ordering is enough, the counters don't guard any other data
+static std::atomic<std::size_t> total_conversions(0);
+static std::atomic<std::chrono::nanoseconds::rep> total_conversion_time(0);
+static std::atomic<std::size_t> total_allocated_bytes(0);
+static std::atomic<std::size_t> total_arena_chunks(0);
+static std::atomic<std::size_t> arena_bytes(0);
+
+ProfileCounters ProfileCounters::operator-(const ProfileCounters & rhs) const {
+    ProfileCounters result;
+    result.conversions = conversions - rhs.conversions;
+    result.conversion_time = conversion_time - rhs.conversion_time;
+    result.allocated_bytes = allocated_bytes - rhs.allocated_bytes;
+    result.arena_chunks = arena_chunks - rhs.arena_chunks;
+    return result;
+}
+
+void record_conversion(std::chrono::nanoseconds duration) {
+    total_conversions.fetch_add(1, std::memory_order_relaxed);
+    total_conversion_time.fetch_add(duration.count(),
+                                    std::memory_order_relaxed);
+}
+
+void record_allocation(std::size_t bytes) {
+    total_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void record_arena_chunk(std::size_t bytes) {
+    total_arena_chunks.fetch_add(1, std::memory_order_relaxed);
+    arena_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    record_allocation(bytes);
+}
+
+void record_arena_release(std::size_t bytes) {
+    arena_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+std::size_t arena_bytes_in_use() {
+    return arena_bytes.load(std::memory_order_relaxed);
+}
+
+ProfileCounters profile_counters() {
+    ProfileCounters result;
+    result.conversions = total_conversions.load(std::memory_order_relaxed);
+    result.conversion_time = std::chrono::nanoseconds(
+        total_conversion_time.load(std::memory_order_relaxed));
+    result.allocated_bytes =
+        total_allocated_bytes.load(std::memory_order_relaxed);
+    result.arena_chunks = total_arena_chunks.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @file
+ * @brief Process wide counters of the work done on matrix representations.
+ *        The counters only ever grow, the work done by a piece of code is the
+ *        difference of snapshots taken before and after it. They may be
+ *        updated from any thread.
+ */
+
+/**
+ * @brief A snapshot of the profiling counters.
+ */
+struct ProfileCounters {
+    /**
+     * @brief Number of conversions between representations.
+     */
+    std::size_t conversions = 0;
+
+    /**
+     * @brief Time spent converting representations.
+     */
+    std::chrono::nanoseconds conversion_time{0};
+
+    /**
+     * @brief Bytes of storage allocated by representations.
+     */
+    std::size_t allocated_bytes = 0;
+
+    /**
+     * @brief Chunks taken from the heap by the node arenas of sparse
+     *        matrices, their bytes are included in <b>allocated_bytes</b>.
+     */
+    std::size_t arena_chunks = 0;
+
+    /**
+     * @brief Computes the work done between two snapshots.
+     * @param rhs The earlier snapshot.
+     * @return Difference of the counters.
+     */
+    ProfileCounters operator-(const ProfileCounters & rhs) const;
+};
+
+/**
+ * @brief Counts a conversion of a representation, called by
+ *        <b>Matrix::optimize</b>.
+ * @param duration Time the conversion took.
+ */
+void record_conversion(std::chrono::nanoseconds duration);
+
+/**
+ * @brief Counts storage allocated by a representation, called by the
+ *        constructors of representations.
+ * @param bytes Number of allocated bytes.
+ */
+void record_allocation(std::size_t bytes);
+
+/**
+ * @brief Counts a chunk taken from the heap by a node arena, called by
+ *        <b>NodeArena</b>.
+ * @param bytes Size of the chunk.
+ */
+void record_arena_chunk(std::size_t bytes);
+
+/**
+ * @brief Counts a chunk returned to the heap by a node arena, called by
+ *        <b>NodeArena</b>.
+ * @param bytes Size of the chunk.
+ */
+void record_arena_release(std::size_t bytes);
+
+/**
+ * @brief Getter for the memory currently held by node arenas. Unlike the
+ *        other counters, it decreases as arenas are released.
+ * @return Bytes of the chunks held by node arenas.
+ */
+std::size_t arena_bytes_in_use();
+
+/**
+ * @brief Takes a snapshot of the counters.
+ * @return Current values of the counters.
+ */
+ProfileCounters profile_counters();
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief A minimal allocator returning memory aligned to <b>Alignment</b>
+ *        bytes. Used by contiguous matrix representations, so that every
+ *        row starts at a cache line boundary.
+ * @tparam T Type of the allocated elements.
+ * @tparam Alignment Alignment of the allocated blocks in bytes. Has to be a
+ *                   power of two.
+ */
+template <typename T, std::size_t Alignment = 64> class AlignedAllocator {
+  public:
+    using value_type = T;
+
+    /**
+     * @brief Rebinding support required by standard containers.
+     */
+    template <typename U> struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+    /**
+     * @brief Allocates an aligned block for <b>count</b> elements.
+     * @param count Number of elements.
+     * @return Pointer to the allocated block.
+     * @throws std::bad_alloc if the allocation fails.
+     */
+    T * allocate(std::size_t count) {
+        return static_cast<T *>(
+            ::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    /**
+     * @brief Frees a block previously returned by <b>allocate</b>.
+     * @param ptr Pointer to the block.
+     */
+    void deallocate(T * ptr, std::size_t) noexcept {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return false;
+    }
+};
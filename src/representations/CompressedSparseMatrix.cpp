@@ -0,0 +1,253 @@
+#include "CompressedSparseMatrix.h"
+#include "../iterators/CompressedSparseMatrixIterator.h"
+#include "../profiling/ProfileCounters.h"
+#include "MatrixFormatter.h"
+#include <algorithm>
+#include <stdexcept>
+
+CompressedSparseMatrix::CompressedSparseMatrix(std::size_t r, std::size_t c)
+    : MatrixMemoryRepr(r, c), _row_offsets(r + 1, 0) {
+    if (!_dimensions.rows() || !_dimensions.columns()) {
+        throw std::invalid_argument("Invalid matrix dimensions.");
+    }
+    record_storage();
+}
+
+CompressedSparseMatrix::CompressedSparseMatrix(
+    std::initializer_list<std::initializer_list<double>> init_list)
+    : MatrixMemoryRepr(init_list.size(),
+                       init_list.size() ? init_list.begin()->size() : 0),
+      _row_offsets(1, 0) {
+    if (!_dimensions.rows() || !_dimensions.columns()) {
+        throw std::invalid_argument(
+            "Invalid dimensions of an initializer list.");
+    }
+
+    for (const auto & list : init_list) {
+        std::size_t col = 0;
+        for (const auto & val : list) {
+            if (val != 0) {
+                _column_indices.emplace_back(col);
+                _values.emplace_back(val);
+            }
+            ++col;
+        }
+        if (col != _dimensions.columns()) {
+            throw std::invalid_argument(
+                "Column size mismatch in initializer list.");
+        }
+        _row_offsets.emplace_back(_values.size());
+    }
+    record_storage();
+}
+
+CompressedSparseMatrix::CompressedSparseMatrix(IteratorWrapper begin,
+                                               IteratorWrapper end)
+    : MatrixMemoryRepr(begin.get_matrix_rows(), begin.get_matrix_columns()),
+      _row_offsets(_dimensions.rows() + 1, 0) {
+
+    std::size_t current_row = 0;
+    for (; begin != end; ++begin) {
+        const auto & [pos, val] = *begin;
+        if (val == 0) {
+            continue;
+        }
+        bool row_is_empty = _row_offsets[current_row] == _values.size();
+        if (pos.row < current_row ||
+            (pos.row == current_row && !row_is_empty &&
+             pos.column <= _column_indices.back())) {
+            throw std::invalid_argument("Unsorted range in CSR construction.");
+        }
+        for (; current_row < pos.row; ++current_row) {
+            _row_offsets[current_row + 1] = _values.size();
+        }
+        _column_indices.emplace_back(pos.column);
+        _values.emplace_back(val);
+    }
+    for (; current_row < _dimensions.rows(); ++current_row) {
+        _row_offsets[current_row + 1] = _values.size();
+    }
+    record_storage();
+}
+
+CompressedSparseMatrix::CompressedSparseMatrix(
+    std::size_t r, std::size_t c, std::vector<std::size_t> && row_offsets,
+    std::vector<std::size_t> && column_indices, std::vector<double> && values)
+    : MatrixMemoryRepr(r, c), _row_offsets(std::move(row_offsets)),
+      _column_indices(std::move(column_indices)), _values(std::move(values)) {
+    if (!_dimensions.rows() || !_dimensions.columns()) {
+        throw std::invalid_argument("Invalid matrix dimensions.");
+    }
+    if (_row_offsets.size() != r + 1 ||
+        _column_indices.size() != _values.size() ||
+        _row_offsets.back() != _values.size()) {
+        throw std::invalid_argument("Invalid CSR array sizes.");
+    }
+    record_storage();
+}
+
+MatrixMemoryRepr * CompressedSparseMatrix::clone() const {
+    record_storage();
+    return new CompressedSparseMatrix(*this);
+}
+
+void CompressedSparseMatrix::record_storage() const {
+    record_allocation((_row_offsets.capacity() + _column_indices.capacity()) *
+                          sizeof(std::size_t) +
+                      _values.capacity() * sizeof(double));
+}
+
+std::size_t CompressedSparseMatrix::find(std::size_t row,
+                                         std::size_t column) const {
+    auto first = _column_indices.begin() + _row_offsets[row];
+    auto last = _column_indices.begin() + _row_offsets[row + 1];
+    return std::lower_bound(first, last, column) - _column_indices.begin();
+}
+
+std::optional<double> CompressedSparseMatrix::at(std::size_t row,
+                                                 std::size_t column) const {
+    if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
+        return std::nullopt;
+    }
+    std::size_t index = find(row, column);
+    if (index == _row_offsets[row + 1] || _column_indices[index] != column) {
+        return 0;
+    }
+    return _values[index];
+}
+
+void CompressedSparseMatrix::store(std::size_t row, std::size_t column,
+                                   double value) {
+    _column_view.reset();
+    std::size_t index = find(row, column);
+    bool is_stored =
+        index != _row_offsets[row + 1] && _column_indices[index] == column;
+
+    if (is_stored && value != 0) {
+        _values[index] = value;
+        return;
+    }
+    if (is_stored) {
+        _column_indices.erase(_column_indices.begin() + index);
+        _values.erase(_values.begin() + index);
+        for (std::size_t i = row + 1; i < _row_offsets.size(); i++) {
+            --_row_offsets[i];
+        }
+        return;
+    }
+    if (value != 0) {
+        _column_indices.insert(_column_indices.begin() + index, column);
+        _values.insert(_values.begin() + index, value);
+        for (std::size_t i = row + 1; i < _row_offsets.size(); i++) {
+            ++_row_offsets[i];
+        }
+    }
+}
+
+void CompressedSparseMatrix::add(std::size_t row, std::size_t column,
+                                 double val) {
+    if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
+        throw std::out_of_range("Add: index out of bounds");
+    }
+    store(row, column, at(row, column).value() + val);
+}
+
+void CompressedSparseMatrix::modify(std::size_t row, std::size_t column,
+                                    double new_val) {
+    if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
+        throw std::out_of_range("Modify: index out of bounds");
+    }
+    store(row, column, new_val);
+}
+
+void CompressedSparseMatrix::swap_rows(std::size_t f_row, std::size_t s_row) {
+    if (f_row >= _dimensions.rows() || s_row >= _dimensions.rows()) {
+        throw std::out_of_range("Swap_rows: index out of range");
+    }
+    if (f_row == s_row) {
+        return;
+    }
+    _column_view.reset();
+    std::size_t top = std::min(f_row, s_row);
+    std::size_t bottom = std::max(f_row, s_row);
+
+    // [top row][rows in between][bottom row] -> [bottom row][...][top row]
+    std::size_t first = _row_offsets[top];
+    std::size_t top_end = _row_offsets[top + 1];
+    std::size_t bottom_begin = _row_offsets[bottom];
+    std::size_t last = _row_offsets[bottom + 1];
+
+    auto swap_segments = [&](auto & vec) {
+        auto base = vec.begin();
+        std::rotate(base + first, base + top_end, base + last);
+        // the top row is now at the end, the middle rows precede it
+        std::size_t bottom_len = last - bottom_begin;
+        std::size_t middle_len = bottom_begin - top_end;
+        std::rotate(base + first, base + first + middle_len,
+                    base + first + middle_len + bottom_len);
+    };
+    swap_segments(_column_indices);
+    swap_segments(_values);
+
+    std::size_t top_len = top_end - first;
+    std::size_t bottom_len = last - bottom_begin;
+    for (std::size_t i = top + 1; i <= bottom; i++) {
+        _row_offsets[i] = _row_offsets[i] + bottom_len - top_len;
+    }
+}
+
+void CompressedSparseMatrix::print(std::ostream & os) const {
+    MatrixFormatter formatter(os, _dimensions.columns());
+    // a single pass over the elements, the zeroes between them are counted
+    std::size_t next = 0;
+    for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+        std::size_t index = row * _dimensions.columns() + column;
+        formatter.zeros(index - next);
+        formatter.value(val);
+        next = index + 1;
+    });
+    formatter.zeros(_dimensions.rows() * _dimensions.columns() - next);
+}
+
+IteratorWrapper CompressedSparseMatrix::begin() const {
+    return {new CompressedSparseMatrixIterator(this, 0)};
+}
+
+IteratorWrapper CompressedSparseMatrix::end() const {
+    return {new CompressedSparseMatrixIterator(this, _values.size())};
+}
+
+std::size_t CompressedSparseMatrix::nnz() const { return _values.size(); }
+
+bool CompressedSparseMatrix::is_efficient(double ratio) const {
+    return _values.size() <=
+           (1 - ratio) * (_dimensions.rows() * _dimensions.columns());
+}
+
+const CompressedSparseMatrix::ColumnView & CompressedSparseMatrix::csc() const {
+    if (_column_view) {
+        return *_column_view;
+    }
+    auto view = std::make_shared<ColumnView>();
+    view->column_offsets.assign(_dimensions.columns() + 1, 0);
+    view->row_indices.resize(_values.size());
+    view->values.resize(_values.size());
+
+    for (const auto & column : _column_indices) {
+        ++view->column_offsets[column + 1];
+    }
+    for (std::size_t j = 0; j < _dimensions.columns(); j++) {
+        view->column_offsets[j + 1] += view->column_offsets[j];
+    }
+    std::vector<std::size_t> next(view->column_offsets.begin(),
+                                  view->column_offsets.end() - 1);
+    for (std::size_t i = 0; i < _dimensions.rows(); i++) {
+        for (std::size_t k = _row_offsets[i]; k < _row_offsets[i + 1]; k++) {
+            std::size_t dst = next[_column_indices[k]]++;
+            view->row_indices[dst] = i;
+            view->values[dst] = _values[k];
+        }
+    }
+    _column_view = view;
+    return *_column_view;
+}
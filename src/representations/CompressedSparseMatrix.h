@@ -0,0 +1,278 @@
+#pragma once
+
+#include "MatrixMemoryRepr.h"
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief A sparse matrix stored in the compressed sparse row (CSR) format.
+ *        Non-zero elements are kept in three flat arrays, sorted by their
+ *        rows and columns. Lookups are logarithmic in the number of non-zero
+ *        elements of a single row, but inserting a new non-zero element
+ *        shifts the rest of the arrays, so this representation is meant for
+ *        matrices, which are mostly read. For matrices under heavy
+ *        modification, use <b>SparseMatrix</b> instead.
+ */
+class CompressedSparseMatrix : public MatrixMemoryRepr {
+    friend class CompressedSparseMatrixIterator;
+
+  public:
+
+    /**
+     * @brief A compressed sparse column (CSC) view of the matrix. Holds a
+     *        copy of the elements sorted by their columns and rows.
+     */
+    struct ColumnView {
+
+        /**
+         * @brief Elements of column <b>j</b> are stored in range
+         *        [<b>column_offsets[j]</b>, <b>column_offsets[j + 1]</b>).
+         */
+        std::vector<std::size_t> column_offsets;
+
+        /**
+         * @brief Row of every stored element.
+         */
+        std::vector<std::size_t> row_indices;
+
+        /**
+         * @brief Value of every stored element.
+         */
+        std::vector<double> values;
+    };
+
+    /**
+     * @brief Creates a zero-filled matrix of the provided dimensions.
+     * @param rows The amount of desired rows.
+     * @param columns The amount of desired columns.
+     * @throws std::invalid_argument if rows or columns are equal to zero.
+     */
+    CompressedSparseMatrix(std::size_t rows, std::size_t columns);
+
+    /**
+     * @brief Initializes the matrix with the provided values. Dimensions are
+     *        set by the number of rows and columns of the initializer list.
+     *        Only non-zero values are stored.
+     * @param initializerList An initializer list of values to load into
+     *                        the matrix.
+     * @throws std::invalid_argument if the amount of columns is not consistent
+     *                               across all rows or if the initializer list
+     *                               has zero rows or columns.
+     */
+    CompressedSparseMatrix(
+        std::initializer_list<std::initializer_list<double>> initializerList);
+
+    /**
+     * @brief Builds the matrix from a range determined by two iterators in a
+     *        single pass. The range has to be sorted by rows and columns,
+     *        which holds for the iterators of all representations, such as
+     *        <b>SparseMatrixIterator</b>. Elements equal to zero are skipped.
+     * @param begin The beginning of the given range.
+     * @param end End of the given range.
+     * @throws std::invalid_argument if the range isn't sorted.
+     */
+    CompressedSparseMatrix(IteratorWrapper begin, IteratorWrapper end);
+
+    /**
+     * @brief Adopts already compressed arrays without copying them. Elements
+     *        of row <b>i</b> are stored in range [<b>row_offsets[i]</b>,
+     *        <b>row_offsets[i + 1]</b>) of <b>column_indices</b> and
+     *        <b>values</b>, sorted by their columns. Values should be
+     *        non-zero, only the sizes of the arrays are checked.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param row_offsets Offsets of the rows, <b>rows + 1</b> elements.
+     * @param column_indices Columns of the stored elements.
+     * @param values Values of the stored elements.
+     * @throws std::invalid_argument if rows or columns are equal to zero or
+     *                               if the sizes of the arrays don't match.
+     */
+    CompressedSparseMatrix(std::size_t rows, std::size_t columns,
+                           std::vector<std::size_t> && row_offsets,
+                           std::vector<std::size_t> && column_indices,
+                           std::vector<double> && values);
+
+    /**
+     * @brief Returns a pointer to a dynamically allocated copy of the matrix.
+     *        It is the programmer's responsibility to free this pointer.
+     * @return A pointer to the dynamically allocated copy.
+     */
+    MatrixMemoryRepr * clone() const override;
+
+    /**
+     * @brief Returns the element at the given indices, or an empty optional
+     *        object, if the indices exceed the dimensions of the matrix.
+     *        Standard zero-based indexing is presumed.
+     * @param row Row of the element in question.
+     * @param column Column of the element in question.
+     * @return Value at the given indices, or an empty optional object, if the
+     *         indices exceed the dimensions of the matrix.
+     */
+    std::optional<double> at(std::size_t row, std::size_t column) const override;
+
+    /**
+     * @brief Increases the element's value at the given indices by
+     *        <b>value</b>. Standard zero-based indexing is presumed. Creating
+     *        a new non-zero element is linear in the number of non-zero
+     *        elements.
+     * @param row Row of the element in question.
+     * @param column Column of the element in question.
+     * @param value The value to add to the given element.
+     * @throws std::out_of_range if the indices exceed the dimensions of the
+     *                           matrix.
+     */
+    void add(std::size_t row, std::size_t column, double value) override;
+
+    /**
+     * @brief Changes the element at the given indices to <b>value</b>.
+     *        Standard zero-based indexing is presumed. Creating a new non-zero
+     *        element or erasing an existing one is linear in the number of
+     *        non-zero elements.
+     * @param row Row of the given element.
+     * @param column Column of the given element.
+     * @param value Value, which will replace the element at the given indices.
+     * @throws std::out_of_range if the indices exceed the dimensions of the
+     *                           matrix.
+     */
+    void modify(std::size_t row, std::size_t column, double value) override;
+
+    /**
+     * @brief Swaps elements in <b>first_row</b> and <b>second_row</b>.
+     *        Standard zero-based indexing is presumed.
+     * @param first_row Index of the row to swap with second_row.
+     * @param second_row Index of the row to swap with first_row.
+     * @throws std::out_of_range If at least one the indices exceeds the
+     *                           dimensions of the matrix.
+     */
+    void swap_rows(std::size_t first_row, std::size_t second_row) override;
+
+    /**
+     * @brief Getter for the number of stored elements. Zeroes are never
+     *        stored, so this is the number of non-zero elements.
+     * @return Number of non-zero elements.
+     */
+    std::size_t nnz() const override;
+
+    /**
+     * @brief Determines, whether the representation as a sparse matrix is
+     *        effective for the given ratio.
+     * @param ratio The ratio to determine the efficiency of the representation.
+     * @return True if the matrix has at least ratio*maximum_possible_elements
+     *         zeroes, false otherwise.
+     */
+    bool is_efficient(double ratio) const override;
+
+    /**
+     * @brief Returns an iterator to the first non-zero element of the matrix.
+     * @return An iterator to the first non-zero element of the matrix.
+     */
+    IteratorWrapper begin() const override;
+
+    /**
+     * @brief Returns an iterator past the last non-zero element of the matrix.
+     * @return An iterator past the last element of the matrix.
+     */
+    IteratorWrapper end() const override;
+
+    /**
+     * @brief Calls <b>visit(row, column, value)</b> for every non-zero
+     *        element of the matrix in row-major order. Unlike the iterators,
+     *        no allocations or virtual calls are involved.
+     * @param visit Callable invoked for every non-zero element.
+     */
+    template <typename Visitor> void for_each_nonzero(Visitor && visit) const {
+        for (std::size_t i = 0; i < _dimensions.rows(); i++) {
+            for (std::size_t k = _row_offsets[i]; k < _row_offsets[i + 1];
+                 k++) {
+                visit(i, _column_indices[k], _values[k]);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns a compressed sparse column view of the matrix. The view
+     *        is built on the first call and kept until the matrix is modified.
+     * @return A reference to the column view, valid until the matrix is
+     *         modified or destroyed.
+     */
+    const ColumnView & csc() const;
+
+    /**
+     * @brief Getter for the row offsets. Elements of row <b>i</b> are stored
+     *        in range [<b>row_offsets()[i]</b>, <b>row_offsets()[i + 1]</b>)
+     *        of <b>column_indices()</b> and <b>values()</b>.
+     * @return A const reference to the row offsets.
+     */
+    const std::vector<std::size_t> & row_offsets() const {
+        return _row_offsets;
+    }
+
+    /**
+     * @brief Getter for the columns of the stored elements.
+     * @return A const reference to the column indices.
+     */
+    const std::vector<std::size_t> & column_indices() const {
+        return _column_indices;
+    }
+
+    /**
+     * @brief Getter for the values of the stored elements.
+     * @return A const reference to the values.
+     */
+    const std::vector<double> & values() const { return _values; }
+
+  protected:
+
+    /**
+     * @brief Prints the matrix to the provided output stream in a bracket
+     *        format. No whitespace is printed at the end of the matrix.
+     * @param os Stream to print the matrix into.
+     */
+    void print(std::ostream & os) const override;
+
+  private:
+
+    /**
+     * @brief Offsets of the rows into <b>_column_indices</b> and
+     *        <b>_values</b>. Has <b>rows + 1</b> elements.
+     */
+    std::vector<std::size_t> _row_offsets;
+
+    /**
+     * @brief Columns of the stored elements, sorted within each row.
+     */
+    std::vector<std::size_t> _column_indices;
+
+    /**
+     * @brief Values of the stored elements. Only non-zero values are present.
+     */
+    std::vector<double> _values;
+
+    /**
+     * @brief A lazily built column view. Shared between copies, as it is
+     *        never modified after being built, reset on every modification.
+     */
+    mutable std::shared_ptr<const ColumnView> _column_view;
+
+    /**
+     * @brief Counts the storage of the matrix as allocated, see
+     *        <b>record_allocation</b>.
+     */
+    void record_storage() const;
+
+    /**
+     * @brief Looks up the storage index of the element at the given indices.
+     * @param row Row of the element.
+     * @param column Column of the element.
+     * @return Index of the element in <b>_values</b> if it is stored, or the
+     *         index, at which it would be inserted, otherwise.
+     */
+    std::size_t find(std::size_t row, std::size_t column) const;
+
+    /**
+     * @brief Stores <b>value</b> at the given indices, inserting or erasing
+     *        the element as needed. Bounds are not checked.
+     */
+    void store(std::size_t row, std::size_t column, double value);
+};
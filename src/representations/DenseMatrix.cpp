@@ -1,106 +1,140 @@
 #include "DenseMatrix.h"
 #include "../iterators/DenseMatrixIterator.h"
 #include "../iterators/IteratorWrapper.h"
+#include "../profiling/ProfileCounters.h"
+#include "MatrixFormatter.h"
 #include "MatrixMemoryRepr.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
 #include <vector>
 
+// number of doubles in a single cache line
+static inline constexpr std::size_t ROW_ALIGNMENT = 8;
+
+std::size_t DenseMatrix::stride_for(std::size_t columns) {
+    return (columns + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+}
+
+void DenseMatrix::allocate() {
+    _stride = stride_for(_dimensions.columns());
+    _data.assign(_dimensions.rows() * _stride, 0);
+    _row_index.resize(_dimensions.rows());
+    std::iota(_row_index.begin(), _row_index.end(), 0);
+    record_storage();
+}
+
+void DenseMatrix::record_storage() const {
+    record_allocation(_data.capacity() * sizeof(double) +
+                      _row_index.capacity() * sizeof(std::size_t));
+}
+
 DenseMatrix::DenseMatrix(std::size_t row, std::size_t col)
-    : MatrixMemoryRepr(row, col), _data(row) {
+    : MatrixMemoryRepr(row, col) {
     if (!_dimensions.rows() || !_dimensions.columns()) {
         throw std::invalid_argument("Invalid matrix dimensions.");
     }
-
-    for (auto & vec : _data) {
-        vec.resize(col);
-    }
+    allocate();
 }
 
 DenseMatrix::DenseMatrix(
     std::initializer_list<std::initializer_list<double>> init)
-    : MatrixMemoryRepr(init.size(), init.size() ? init.begin()->size() : 0),
-      _data(init.size()) {
+    : MatrixMemoryRepr(init.size(), init.size() ? init.begin()->size() : 0) {
     if (!_dimensions.rows() || !_dimensions.columns()) {
         throw std::invalid_argument("Invalid initializer list dimensions.");
     }
+    allocate();
 
-    std::size_t row = 0;
+    std::size_t row_index = 0;
     for (const auto & list : init) {
-        _data[row].resize(_dimensions.columns());
-        std::size_t col = 0;
-        for (const auto & val : list) {
-            _data[row][col] = val;
-            ++col;
-        }
-        if (col != _dimensions.columns()) {
+        if (list.size() != _dimensions.columns()) {
             throw std::invalid_argument(
                 "Column size mismatch in initializer list.");
         }
-        ++row;
+        std::copy(list.begin(), list.end(), row(row_index));
+        ++row_index;
     }
+    recount_nonzeros();
 }
 
 DenseMatrix::DenseMatrix(IteratorWrapper begin, IteratorWrapper end)
-    : MatrixMemoryRepr(begin.get_matrix_rows(), begin.get_matrix_columns()),
-      _data(_dimensions.rows()) {
-
-    for (auto & column : _data) {
-        column.resize(_dimensions.columns());
-    }
+    : MatrixMemoryRepr(begin.get_matrix_rows(), begin.get_matrix_columns()) {
+    allocate();
 
     for (; begin != end; ++begin) {
         const auto & [pos, val] = *begin;
-        _data[pos.row][pos.column] = val;
+        if (val != 0) {
+            row(pos.row)[pos.column] = val;
+            ++_nnz;
+        }
     }
 }
 
-MatrixMemoryRepr * DenseMatrix::clone() const { return new DenseMatrix(*this); }
+DenseMatrix::DenseMatrix(std::size_t rows, std::size_t columns, Buffer && data)
+    : MatrixMemoryRepr(rows, columns), _stride(stride_for(columns)),
+      _data(std::move(data)), _row_index(rows) {
+    if (!rows || !columns) {
+        throw std::invalid_argument("Invalid matrix dimensions.");
+    }
+    if (_data.size() != rows * _stride) {
+        throw std::invalid_argument("Invalid size of the matrix buffer.");
+    }
+    std::iota(_row_index.begin(), _row_index.end(), 0);
+    for (std::size_t i = 0; i < rows; i++) {
+        std::fill(row(i) + columns, row(i) + _stride, 0);
+    }
+    recount_nonzeros();
+    record_storage();
+}
+
+MatrixMemoryRepr * DenseMatrix::clone() const {
+    record_storage();
+    return new DenseMatrix(*this);
+}
 
 std::optional<double> DenseMatrix::at(std::size_t row,
                                       std::size_t column) const {
     if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
         return std::nullopt;
     }
-    return _data[row][column];
+    return this->row(row)[column];
 }
 
 void DenseMatrix::add(std::size_t row, std::size_t column, double val) {
     if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
         throw std::out_of_range("Add: index of out bounds");
     }
-    _data[row][column] += val;
+    double & element = this->row(row)[column];
+    _nnz -= element != 0;
+    element += val;
+    _nnz += element != 0;
 }
 
 void DenseMatrix::modify(std::size_t row, std::size_t column, double new_val) {
     if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
         throw std::out_of_range("Modify: index out of bounds");
     }
-    _data[row][column] = new_val;
+    double & element = this->row(row)[column];
+    _nnz -= element != 0;
+    element = new_val;
+    _nnz += element != 0;
 }
 
 void DenseMatrix::swap_rows(std::size_t f_row, std::size_t s_row) {
-    if (f_row >= _dimensions.rows() || s_row >= _dimensions.columns()) {
+    if (f_row >= _dimensions.rows() || s_row >= _dimensions.rows()) {
         throw std::out_of_range("Swap_rows: index out of range");
     }
-    std::swap(_data[f_row], _data[s_row]);
+    std::swap(_row_index[f_row], _row_index[s_row]);
 }
 
 void DenseMatrix::print(std::ostream & os) const {
+    MatrixFormatter formatter(os, _dimensions.columns());
     for (std::size_t row_index = 0; row_index < _dimensions.rows();
          row_index++) {
-        os << "[ ";
-        for (std::size_t val_index = 0; val_index < _dimensions.columns() - 1;
+        const double * row_data = row(row_index);
+        for (std::size_t val_index = 0; val_index < _dimensions.columns();
              val_index++) {
-            double val = _data[row_index][val_index] == 0
-                             ? 0
-                             : _data[row_index][val_index];
-            os << val << ", ";
-        }
-        double last_val = _data[row_index][_dimensions.columns() - 1] == 0
-                              ? 0
-                              : _data[row_index][_dimensions.columns() - 1];
-        os << last_val << " ]";
-        if (row_index != _dimensions.rows() - 1) {
-            os << std::endl;
+            formatter.value(row_data[val_index]);
         }
     }
 }
@@ -112,7 +146,19 @@ IteratorWrapper DenseMatrix::begin() const {
 IteratorWrapper DenseMatrix::end() const {
     return {new DenseMatrixIterator(this, _dimensions.rows(), 0)};
 }
+std::size_t DenseMatrix::nnz() const { return _nnz; }
+
+void DenseMatrix::recount_nonzeros() {
+    _nnz = 0;
+    for (std::size_t i = 0; i < _dimensions.rows(); i++) {
+        const double * values = row(i);
+        for (std::size_t j = 0; j < _dimensions.columns(); j++) {
+            _nnz += values[j] != 0;
+        }
+    }
+}
+
 bool DenseMatrix::is_efficient(double ratio) const {
-    return begin().distance(end()) >
+    return _nnz >
            (1 - ratio) * (_dimensions.rows() * _dimensions.columns());
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AlignedAllocator.h"
 #include "MatrixMemoryRepr.h"
 #include <vector>
 
@@ -14,6 +15,12 @@ class DenseMatrix : public MatrixMemoryRepr {
 
   public:
 
+    /**
+     * @brief Type of the contiguous buffer holding the elements. Every row
+     *        starts at a cache line boundary.
+     */
+    using Buffer = std::vector<double, AlignedAllocator<double>>;
+
     /**
      * @brief Created a zero-filled matrix of the given dimensions. This
      *        representation is inefficient for this type of matrix, as no
@@ -45,6 +52,27 @@ class DenseMatrix : public MatrixMemoryRepr {
      */
     DenseMatrix(IteratorWrapper begin, IteratorWrapper end);
 
+    /**
+     * @brief Creates a matrix adopting a row-major buffer without copying
+     *        it. Row <b>i</b> starts at <b>i * stride_for(columns)</b>, the
+     *        padding past the last column of each row is zeroed.
+     * @param rows Number of rows of the matrix.
+     * @param columns Number of columns of the matrix.
+     * @param data Buffer with the elements of the matrix.
+     * @throws std::invalid_argument if rows or columns are equal to zero or
+     *                               the size of the buffer doesn't match.
+     */
+    DenseMatrix(std::size_t rows, std::size_t columns, Buffer && data);
+
+    /**
+     * @brief Returns the distance between the beginnings of two adjacent
+     *        rows of a matrix with the given number of columns, see
+     *        <b>stride()</b>. Used to lay out buffers for adoption.
+     * @param columns Number of columns of the matrix.
+     * @return Row stride in elements.
+     */
+    static std::size_t stride_for(std::size_t columns);
+
     /**
      * @brief Returns a pointer to a dynamically allocated copy of the matrix.
      *        It is the programmer's responsibility to free this pointer.
@@ -106,6 +134,20 @@ class DenseMatrix : public MatrixMemoryRepr {
      * @return True if the matrix has at least (1 - ratio)*max_number_of_elements
      *         elements, which are not equal to zero.
      */
+    /**
+     * @brief Getter for the number of non-zero elements, maintained by
+     *        <b>add</b> and <b>modify</b>.
+     * @return Number of non-zero elements.
+     */
+    std::size_t nnz() const override;
+
+    /**
+     * @brief Counts the non-zero elements again. Writes through
+     *        <b>row()</b> aren't tracked, so whoever fills the matrix
+     *        that way has to call this afterwards.
+     */
+    void recount_nonzeros();
+
     bool is_efficient(double ratio) const override;
 
     /**
@@ -120,6 +162,54 @@ class DenseMatrix : public MatrixMemoryRepr {
      */
     IteratorWrapper end() const override;
 
+    /**
+     * @brief Calls <b>visit(row, column, value)</b> for every non-zero
+     *        element of the matrix in row-major order. Unlike the iterators,
+     *        no allocations or virtual calls are involved.
+     * @param visit Callable invoked for every non-zero element.
+     */
+    template <typename Visitor> void for_each_nonzero(Visitor && visit) const {
+        for (std::size_t i = 0; i < _dimensions.rows(); i++) {
+            const double * values = row(i);
+            for (std::size_t j = 0; j < _dimensions.columns(); j++) {
+                if (values[j] != 0) {
+                    visit(i, j, values[j]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Returns a pointer to the first element of the given row. The
+     *        following <b>columns()</b> elements belong to the same row.
+     *        No bounds checks are performed.
+     * @param row Index of the row.
+     * @return Pointer to the first element of the row.
+     */
+    const double * row(std::size_t row) const {
+        return _data.data() + _row_index[row] * _stride;
+    }
+
+    /**
+     * @brief Returns a pointer to the first element of the given row. The
+     *        following <b>columns()</b> elements belong to the same row.
+     *        No bounds checks are performed.
+     * @param row Index of the row.
+     * @return Pointer to the first element of the row.
+     * @note Writes through the pointer aren't reflected in <b>nnz()</b>
+     *       until <b>recount_nonzeros()</b> is called.
+     */
+    double * row(std::size_t row) {
+        return _data.data() + _row_index[row] * _stride;
+    }
+
+    /**
+     * @brief Getter for the leading dimension of the buffer, ie. the distance
+     *        between the beginnings of two physically adjacent rows.
+     * @return Leading dimension of the buffer in elements.
+     */
+    std::size_t stride() const { return _stride; }
+
   protected:
 
     /**
@@ -132,8 +222,38 @@ class DenseMatrix : public MatrixMemoryRepr {
   private:
 
     /**
-     * @brief A 2D vector serving as a container for the elements of the matrix.
-     *        All elements, including the ones equal to zero, are stored.
+     * @brief Leading dimension of <b>_data</b>. The number of columns rounded
+     *        up to a whole cache line, the padding is always zero.
+     */
+    std::size_t _stride;
+
+    /**
+     * @brief A contiguous row-major buffer serving as a container for the
+     *        elements of the matrix. All elements, including the ones equal
+     *        to zero, are stored.
+     */
+    Buffer _data;
+
+    /**
+     * @brief Maps logical rows to physical rows of <b>_data</b>. Row swaps
+     *        only exchange two indices instead of moving the elements.
+     */
+    std::vector<std::size_t> _row_index;
+
+    /**
+     * @brief Number of non-zero elements in <b>_data</b>.
+     */
+    std::size_t _nnz = 0;
+
+    /**
+     * @brief Allocates a zero-filled buffer and an identity row mapping
+     *        for the current dimensions.
+     */
+    void allocate();
+
+    /**
+     * @brief Counts the storage of the matrix as allocated, see
+     *        <b>record_allocation</b>.
      */
-    std::vector<std::vector<double>> _data;
+    void record_storage() const;
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CompressedSparseMatrix.h"
+#include "DenseMatrix.h"
+#include "MatrixMemoryRepr.h"
+#include "SparseMatrix.h"
+
+/**
+ * @brief Calls <b>visit(row, column, value)</b> for every non-zero element of
+ *        the given matrix in row-major order. The representation is resolved
+ *        once and the loop is instantiated for it, so the traversal doesn't
+ *        allocate iterators or make a virtual call per element. Unknown
+ *        representations fall back to <b>begin()</b> and <b>end()</b>.
+ * @param mx Matrix to traverse.
+ * @param visit Callable invoked for every non-zero element.
+ */
+template <typename Visitor>
+void for_each_nonzero(const MatrixMemoryRepr & mx, Visitor && visit) {
+    if (auto dense = dynamic_cast<const DenseMatrix *>(&mx)) {
+        dense->for_each_nonzero(visit);
+    } else if (auto compressed =
+                   dynamic_cast<const CompressedSparseMatrix *>(&mx)) {
+        compressed->for_each_nonzero(visit);
+    } else if (auto sparse = dynamic_cast<const SparseMatrix *>(&mx)) {
+        sparse->for_each_nonzero(visit);
+    } else {
+        for (const auto & [pos, value] : mx) {
+            if (value != 0) {
+                visit(pos.row, pos.column, value);
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include "MatrixFormatter.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+// more digits don't tell distinct doubles apart, and the elements have to
+// fit the reserved space
+static int capped_precision(const std::ostream & os) {
+    return static_cast<int>(std::clamp<std::streamsize>(
+        os.precision(), 0, std::numeric_limits<double>::max_digits10));
+}
+
+MatrixFormatter::MatrixFormatter(std::ostream & os, std::size_t columns)
+    : _os(os), _columns(columns), _precision(capped_precision(os)) {}
+
+MatrixFormatter::~MatrixFormatter() {
+    _os.write(_buffer, _cursor - _buffer);
+}
+
+void MatrixFormatter::value(double val) {
+    reserve();
+    open_element();
+    if (val == 0) {
+        *_cursor++ = '0';
+    } else {
+        // the element always fits, the reserved space is never exceeded
+        _cursor = std::to_chars(_cursor, _buffer + BUFFER_SIZE, val,
+                                std::chars_format::general, _precision)
+                      .ptr;
+    }
+    close_element();
+}
+
+void MatrixFormatter::zeros(std::size_t count) {
+    for (; count; count--) {
+        reserve();
+        open_element();
+        *_cursor++ = '0';
+        close_element();
+    }
+}
+
+void MatrixFormatter::reserve() {
+    if (static_cast<std::size_t>(_buffer + BUFFER_SIZE - _cursor) <
+        MAX_ELEMENT_LENGTH) {
+        _os.write(_buffer, _cursor - _buffer);
+        _cursor = _buffer;
+    }
+}
+
+void MatrixFormatter::open_element() {
+    if (_column) {
+        return;
+    }
+    if (!_first_row) {
+        *_cursor++ = '\n';
+    }
+    _first_row = false;
+    std::memcpy(_cursor, "[ ", 2);
+    _cursor += 2;
+}
+
+void MatrixFormatter::close_element() {
+    if (++_column == _columns) {
+        std::memcpy(_cursor, " ]", 2);
+        _column = 0;
+    } else {
+        std::memcpy(_cursor, ", ", 2);
+    }
+    _cursor += 2;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+/**
+ * @brief Prints matrices in the bracket format, one row per line:
+ *        <b>[ 1, 0, 2.5 ]</b>. Values are formatted by <b>std::to_chars</b>
+ *        like <b>ostream << double</b> does, with the precision of the stream
+ *        capped at 17 significant digits, and collected in a buffer, which
+ *        is written to the stream whenever it fills up. Values have to be
+ *        passed in row-major order, runs of zeroes may be passed at once.
+ */
+class MatrixFormatter {
+  public:
+
+    /**
+     * @brief Initializes the formatter.
+     * @param os Stream to print into.
+     * @param columns Number of columns of the printed matrix.
+     */
+    MatrixFormatter(std::ostream & os, std::size_t columns);
+
+    MatrixFormatter(const MatrixFormatter &) = delete;
+
+    MatrixFormatter & operator=(const MatrixFormatter &) = delete;
+
+    /**
+     * @brief Writes the rest of the buffer to the stream.
+     */
+    ~MatrixFormatter();
+
+    /**
+     * @brief Prints the next element of the matrix. Negative zeroes are
+     *        printed as zeroes.
+     * @param val Value of the element.
+     */
+    void value(double val);
+
+    /**
+     * @brief Prints the next <b>count</b> elements, which are all zero.
+     * @param count Number of elements.
+     */
+    void zeros(std::size_t count);
+
+  private:
+
+    /**
+     * @brief Space reserved for a single element with its separators.
+     */
+    static constexpr std::size_t MAX_ELEMENT_LENGTH = 64;
+
+    static constexpr std::size_t BUFFER_SIZE = 16384;
+
+    /**
+     * @brief Writes the buffer to the stream, unless it has room for
+     *        another element.
+     */
+    void reserve();
+
+    /**
+     * @brief Prints the separator preceding the next element.
+     */
+    void open_element();
+
+    /**
+     * @brief Prints the separator following an element.
+     */
+    void close_element();
+
+    std::ostream & _os;
+
+    std::size_t _columns;
+
+    int _precision;
+
+    /**
+     * @brief Column of the next element.
+     */
+    std::size_t _column = 0;
+
+    bool _first_row = true;
+
+    char _buffer[BUFFER_SIZE];
+
+    char * _cursor = _buffer;
+};
@@ -98,6 +98,14 @@ class MatrixMemoryRepr {
      */
     virtual void swap_rows(std::size_t first_row, std::size_t second_row) = 0;
 
+    /**
+     * @brief Getter for the number of non-zero elements of the matrix. The
+     *        count is kept up to date by all modifying methods, so the query
+     *        doesn't scan the matrix.
+     * @return Number of non-zero elements.
+     */
+    virtual std::size_t nnz() const = 0;
+
     /**
      * @brief Checks the efficiency of the representation in the given ratio.
      * @param ratio Ratio of zeroes to the number of elements.
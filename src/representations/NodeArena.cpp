@@ -0,0 +1,70 @@
+#include "NodeArena.h"
+#include "../profiling/ProfileCounters.h"
+#include <algorithm>
+#include <new>
+
+// chunk sizes in blocks, doubling from the first to the largest one, chunks
+// of nodes stay below the threshold at which the heap maps fresh pages
+static constexpr std::size_t FIRST_CHUNK_BLOCKS = 32;
+static constexpr std::size_t MAX_CHUNK_BLOCKS = 1024;
+
+// blocks are aligned like pointers, so that they can hold the free list
+static constexpr std::size_t BLOCK_ALIGNMENT = alignof(void *);
+
+NodeArena::~NodeArena() {
+    for (const auto & [chunk, bytes] : _chunks) {
+        ::operator delete(chunk);
+        record_arena_release(bytes);
+    }
+}
+
+void * NodeArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (!_block_size && alignment <= BLOCK_ALIGNMENT) {
+        _block_size = std::max(bytes, sizeof(FreeBlock));
+        _block_size = (_block_size + BLOCK_ALIGNMENT - 1) /
+                      BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+        _chunk_blocks = FIRST_CHUNK_BLOCKS;
+    }
+    if (!fits(bytes, alignment)) {
+        return ::operator new(bytes);
+    }
+    if (_free) {
+        FreeBlock * block = _free;
+        _free = block->next;
+        return block;
+    }
+    if (_cursor == _end) {
+        grow();
+    }
+    void * result = _cursor;
+    _cursor += _block_size;
+    return result;
+}
+
+void NodeArena::do_deallocate(void * pointer, std::size_t bytes,
+                              std::size_t alignment) {
+    if (!fits(bytes, alignment)) {
+        ::operator delete(pointer);
+        return;
+    }
+    _free = new (pointer) FreeBlock{_free};
+}
+
+bool NodeArena::do_is_equal(
+    const std::pmr::memory_resource & other) const noexcept {
+    return this == &other;
+}
+
+void NodeArena::grow() {
+    std::size_t bytes = _chunk_blocks * _block_size;
+    _chunks.reserve(_chunks.size() + 1);
+    _cursor = static_cast<char *>(::operator new(bytes));
+    _end = _cursor + bytes;
+    _chunks.emplace_back(_cursor, bytes);
+    record_arena_chunk(bytes);
+    _chunk_blocks = std::min(_chunk_blocks * 2, MAX_CHUNK_BLOCKS);
+}
+
+bool NodeArena::fits(std::size_t bytes, std::size_t alignment) const {
+    return bytes <= _block_size && alignment <= BLOCK_ALIGNMENT;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @brief A memory resource for the nodes of a node based container. Blocks
+ *        of the size of the first allocation are carved from chunks taken
+ *        from the heap, freed blocks are kept in a free list and reused.
+ *        Chunks grow geometrically and are returned to the heap all at once
+ *        when the arena is destroyed. Allocations of a different size or
+ *        alignment are passed to the global heap.\n
+ *        Not thread safe, meant to be owned by a single container. Chunks
+ *        are counted by the profiling counters, see
+ *        <b>record_arena_chunk</b>.
+ */
+class NodeArena : public std::pmr::memory_resource {
+  public:
+    NodeArena() = default;
+
+    NodeArena(const NodeArena &) = delete;
+
+    NodeArena & operator=(const NodeArena &) = delete;
+
+    /**
+     * @brief Returns all chunks to the heap. Blocks still in use become
+     *        invalid.
+     */
+    ~NodeArena() override;
+
+  protected:
+
+    /**
+     * @brief Takes a block from the free list or from the current chunk.
+     * @param bytes Size of the allocation.
+     * @param alignment Alignment of the allocation.
+     * @return Pointer to the allocated memory.
+     * @throws std::bad_alloc if a new chunk can't be allocated.
+     */
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    /**
+     * @brief Puts a block to the free list.
+     * @param pointer Memory returned by <b>do_allocate</b>.
+     * @param bytes Size of the allocation.
+     * @param alignment Alignment of the allocation.
+     */
+    void do_deallocate(void * pointer, std::size_t bytes,
+                       std::size_t alignment) override;
+
+    /**
+     * @brief Compares the arena with another resource.
+     * @param other The other resource.
+     * @return True if <b>other</b> is this arena.
+     */
+    bool do_is_equal(const std::pmr::memory_resource & other) const
+        noexcept override;
+
+  private:
+
+    /**
+     * @brief Allocates the next chunk and makes it current.
+     * @throws std::bad_alloc if the chunk can't be allocated.
+     */
+    void grow();
+
+    /**
+     * @brief Decides, whether an allocation is served by the arena.
+     * @param bytes Size of the allocation.
+     * @param alignment Alignment of the allocation.
+     * @return True if the allocation fits a block.
+     */
+    bool fits(std::size_t bytes, std::size_t alignment) const;
+
+    /**
+     * @brief A freed block, linking to the next one.
+     */
+    struct FreeBlock {
+        FreeBlock * next;
+    };
+
+    /**
+     * @brief Size of a block, zero until the first allocation.
+     */
+    std::size_t _block_size = 0;
+
+    /**
+     * @brief Number of blocks in the next chunk.
+     */
+    std::size_t _chunk_blocks = 0;
+
+    FreeBlock * _free = nullptr;
+
+    /**
+     * @brief Unused part of the current chunk.
+     */
+    char * _cursor = nullptr;
+    char * _end = nullptr;
+
+    /**
+     * @brief Chunks with their sizes in bytes.
+     */
+    std::vector<std::pair<void *, std::size_t>> _chunks;
+};
@@ -1,6 +1,7 @@
 #include "SparseMatrix.h"
 #include "../iterators/SparseMatrixIterator.h"
 #include "../matrix_wrapper/MatrixElement.h"
+#include "MatrixFormatter.h"
 
 SparseMatrix::SparseMatrix(std::size_t r, std::size_t c)
     : MatrixMemoryRepr(r, c) {
@@ -23,7 +24,7 @@ SparseMatrix::SparseMatrix(
         std::size_t col = 0;
         for (const auto & val : list) {
             if (val != 0) {
-                _data[{row, col}] = val;
+                _data.emplace_hint(_data.end(), Position(row, col), val);
             }
             ++col;
         }
@@ -40,10 +41,16 @@ SparseMatrix::SparseMatrix(IteratorWrapper begin, IteratorWrapper end)
 
     for (; begin != end; ++begin) {
         const auto & [pos, val] = *begin;
-        _data[pos] = val;
+        // ranges are mostly in row-major order, appending is then constant
+        if (val != 0) {
+            _data.emplace_hint(_data.end(), pos, val);
+        }
     }
 }
 
+SparseMatrix::SparseMatrix(const SparseMatrix & src)
+    : MatrixMemoryRepr(src), _data(src._data, &_arena) {}
+
 MatrixMemoryRepr * SparseMatrix::clone() const {
     return new SparseMatrix(*this);
 }
@@ -63,7 +70,17 @@ void SparseMatrix::add(std::size_t row, std::size_t column, double val) {
     if (row >= _dimensions.rows() || column >= _dimensions.columns()) {
         throw std::out_of_range("Add: index out of bounds");
     }
-    _data[{row, column}] += val;
+    auto element = _data.find({row, column});
+    if (element == _data.end()) {
+        if (val != 0) {
+            _data.emplace(Position(row, column), val);
+        }
+        return;
+    }
+    element->second += val;
+    if (element->second == 0) {
+        _data.erase(element);
+    }
 }
 
 void SparseMatrix::modify(std::size_t row, std::size_t column, double new_val) {
@@ -72,46 +89,46 @@ void SparseMatrix::modify(std::size_t row, std::size_t column, double new_val) {
     }
     if (new_val != 0) {
         _data[{row, column}] = new_val;
+    } else {
+        _data.erase({row, column});
     }
 }
 
 void SparseMatrix::swap_rows(std::size_t f_row, std::size_t s_row) {
-    std::vector<MatrixElement> swap_elements;
     if (f_row >= _dimensions.rows() || s_row >= _dimensions.rows()) {
         throw std::out_of_range("Swap_rows: index out of range");
     }
-    for (const auto & [key, value] : _data) {
-        if (key.row == f_row || key.row == s_row) {
-            swap_elements.emplace_back(key.row, key.column, value);
+    if (f_row == s_row) {
+        return;
+    }
+    // both rows are taken out before reinserting, so elements sharing
+    // a column don't overwrite each other
+    std::vector<MatrixElement> swap_elements;
+    for (std::size_t row : {f_row, s_row}) {
+        auto first = _data.lower_bound({row, 0});
+        auto last = _data.lower_bound({row + 1, 0});
+        for (auto it = first; it != last; ++it) {
+            swap_elements.emplace_back(row == f_row ? s_row : f_row,
+                                       it->first.column, it->second);
         }
+        _data.erase(first, last);
     }
     for (const auto & [pos, val] : swap_elements) {
-        Position new_pos = {pos.row == f_row ? s_row : f_row, pos.column};
-        _data.erase(pos);
-        _data[new_pos] = val;
+        _data.emplace(pos, val);
     }
 }
 
 void SparseMatrix::print(std::ostream & os) const {
-    for (std::size_t i = 0; i < _dimensions.rows(); i++) {
-        os << "[ ";
-        for (std::size_t j = 0; j < _dimensions.columns() - 1; j++) {
-            auto elem = _data.find({i, j});
-            double val = elem == _data.end()
-                             ? 0
-                             : (elem->second == 0 ? 0 : elem->second);
-            os << val << ", ";
-        }
-        auto last_elem = _data.find({i, _dimensions.columns() - 1});
-        double last_val =
-            last_elem == _data.end()
-                ? 0
-                : (last_elem->second == 0 ? 0 : last_elem->second);
-        os << last_val << " ]";
-        if (i != _dimensions.rows() - 1) {
-            os << std::endl;
-        }
-    }
+    MatrixFormatter formatter(os, _dimensions.columns());
+    // a single pass over the elements, the zeroes between them are counted
+    std::size_t next = 0;
+    for_each_nonzero([&](std::size_t row, std::size_t column, double val) {
+        std::size_t index = row * _dimensions.columns() + column;
+        formatter.zeros(index - next);
+        formatter.value(val);
+        next = index + 1;
+    });
+    formatter.zeros(_dimensions.rows() * _dimensions.columns() - next);
 }
 
 IteratorWrapper SparseMatrix::begin() const {
@@ -121,6 +138,8 @@ IteratorWrapper SparseMatrix::begin() const {
 IteratorWrapper SparseMatrix::end() const {
     return {new SparseMatrixIterator(this, _data.end())};
 }
+std::size_t SparseMatrix::nnz() const { return _data.size(); }
+
 bool SparseMatrix::is_efficient(double ratio) const {
     return _data.size() <=
            (1 - ratio) * (_dimensions.rows() * _dimensions.columns());
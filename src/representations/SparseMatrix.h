@@ -2,9 +2,11 @@
 
 #include "../matrix_wrapper/MatrixElement.h"
 #include "MatrixMemoryRepr.h"
+#include "NodeArena.h"
 #include <functional>
 #include <initializer_list>
 #include <map>
+#include <memory_resource>
 #include <vector>
 
 /**
@@ -16,6 +18,8 @@
 class SparseMatrix : public MatrixMemoryRepr {
     friend class SparseMatrixIterator;
   public:
+    using Map = std::pmr::map<Position, double>;
+
     /**
      * @brief Creates a zero-filled representation of a sparse matrix of the
      *        provided dimensions.
@@ -49,6 +53,14 @@ class SparseMatrix : public MatrixMemoryRepr {
      */
     SparseMatrix(IteratorWrapper begin, IteratorWrapper end);
 
+    /**
+     * @brief Copies the elements of <b>src</b> into a new arena.
+     * @param src Matrix to copy.
+     */
+    SparseMatrix(const SparseMatrix & src);
+
+    SparseMatrix & operator=(const SparseMatrix & src) = delete;
+
     /**
      * @brief Returns a pointer to a dynamically allocated copy of the matrix.
      *        It is the programmer's responsibility to free this pointer.
@@ -104,6 +116,13 @@ class SparseMatrix : public MatrixMemoryRepr {
      */
     void swap_rows(std::size_t first_row, std::size_t second_row) override;
 
+    /**
+     * @brief Getter for the number of stored elements. Zeroes are never
+     *        stored, so this is the number of non-zero elements.
+     * @return Number of non-zero elements.
+     */
+    std::size_t nnz() const override;
+
     /**
      * @brief Determines, whether the representation as a sparse matrix is
      *        effective for the given ratio.
@@ -125,6 +144,20 @@ class SparseMatrix : public MatrixMemoryRepr {
      */
     IteratorWrapper end() const override;
 
+    /**
+     * @brief Calls <b>visit(row, column, value)</b> for every non-zero
+     *        element of the matrix in row-major order. Unlike the iterators,
+     *        no allocations or virtual calls are involved.
+     * @param visit Callable invoked for every non-zero element.
+     */
+    template <typename Visitor> void for_each_nonzero(Visitor && visit) const {
+        for (const auto & [pos, value] : _data) {
+            if (value != 0) {
+                visit(pos.row, pos.column, value);
+            }
+        }
+    }
+
   protected:
 
     /**
@@ -136,6 +169,12 @@ class SparseMatrix : public MatrixMemoryRepr {
 
   private:
 
+    /**
+     * @brief Arena for the nodes of <b>_data</b>. Declared before
+     *        <b>_data</b> to outlive it.
+     */
+    NodeArena _arena;
+
     /**
      * @brief A container for the values of the represented matrix.\n
      *        <b>Key</b> - A Position struct with the row and column of the
@@ -145,5 +184,5 @@ class SparseMatrix : public MatrixMemoryRepr {
      *        <b>Value</b> - The value at in the row and column. Only non-zero
      *                       values are present.
      */
-     std::map<Position, double> _data;
+    Map _data{&_arena};
 };
\ No newline at end of file